@@ -4,3 +4,5 @@
 
 #include "CoreMinimal.h"
 
+/** Runtime counters for gameplay systems, viewed with "stat KnightsEscape" */
+DECLARE_STATS_GROUP(TEXT("KnightsEscape"), STATGROUP_KnightsEscape, STATCAT_Advanced);
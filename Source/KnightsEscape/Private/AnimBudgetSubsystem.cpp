@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimBudgetSubsystem.h"
+#include "KnightsEscape.h"
+#include "BudgetedSkeletalMeshComponent.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Anim Budget Allocate"), STAT_AnimBudgetAllocate, STATGROUP_KnightsEscape);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Anim Budget Planned (ms)"), STAT_AnimBudgetPlanned, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Meshes Full Rate"), STAT_AnimMeshesFullRate, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Meshes Throttled"), STAT_AnimMeshesThrottled, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Meshes Stopped"), STAT_AnimMeshesStopped, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarAnimBudgetEnabled(
+	TEXT("ke.AnimBudget.Enabled"),
+	1,
+	TEXT("Whether budgeted skeletal meshes have their update rate limited; 0 updates them every frame."));
+
+static TAutoConsoleVariable<float> CVarAnimBudgetMs(
+	TEXT("ke.AnimBudget.BudgetMs"),
+	1.5f,
+	TEXT("Game thread milliseconds per frame that budgeted skeletal mesh updates may take."));
+
+static TAutoConsoleVariable<int32> CVarAnimBudgetMaxPeriod(
+	TEXT("ke.AnimBudget.MaxPeriod"),
+	8,
+	TEXT("Most frames an on-screen budgeted mesh may go between updates."));
+
+static TAutoConsoleVariable<float> CVarAnimBudgetInitialEstimateMs(
+	TEXT("ke.AnimBudget.InitialEstimateMs"),
+	0.1f,
+	TEXT("Assumed cost of a mesh update before it has been measured."));
+
+static TAutoConsoleVariable<float> CVarAnimBudgetHiddenScale(
+	TEXT("ke.AnimBudget.HiddenSignificanceScale"),
+	0.25f,
+	TEXT("Significance multiplier for meshes that have not been rendered recently."));
+
+
+UAnimBudgetSubsystem::UAnimBudgetSubsystem()
+{
+	NextUpdatePhase = 0;
+}
+
+
+void UAnimBudgetSubsystem::Deinitialize()
+{
+	Components.Empty();
+	Entries.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UAnimBudgetSubsystem::RegisterComponent(UBudgetedSkeletalMeshComponent* Component)
+{
+	if (Component && !Components.Contains(Component))
+	{
+		Components.Add(Component);
+		Component->SetUpdatePhase(NextUpdatePhase++);
+	}
+}
+
+
+void UAnimBudgetSubsystem::UnregisterComponent(UBudgetedSkeletalMeshComponent* Component)
+{
+	Components.RemoveSingleSwap(Component);
+	if (Component)
+	{
+		Component->SetUpdatePeriod(1);
+	}
+}
+
+
+void UAnimBudgetSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AnimBudgetAllocate);
+
+	if (CVarAnimBudgetEnabled.GetValueOnGameThread() == 0)
+	{
+		for (UBudgetedSkeletalMeshComponent* Component : Components)
+		{
+			Component->SetUpdatePeriod(1);
+		}
+		return;
+	}
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Player = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (Player == nullptr)
+	{
+		return;
+	}
+
+	GatherEntries(Player->GetActorLocation());
+
+	Entries.Sort([](const FAnimBudgetEntry& A, const FAnimBudgetEntry& B)
+	{
+		if (A.bAlwaysFullRate != B.bAlwaysFullRate)
+		{
+			return A.bAlwaysFullRate;
+		}
+		return A.Significance > B.Significance;
+	});
+
+	const float BudgetMs = CVarAnimBudgetMs.GetValueOnGameThread();
+	const int32 MaxPeriod = FMath::Max(CVarAnimBudgetMaxPeriod.GetValueOnGameThread(), 2);
+	const float InitialEstimateMs = CVarAnimBudgetInitialEstimateMs.GetValueOnGameThread();
+
+	float PlannedMs = 0.f;
+	int32 NumFullRate = 0;
+	int32 NumThrottled = 0;
+	int32 NumStopped = 0;
+
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		const FAnimBudgetEntry& Entry = Entries[Index];
+		const float MeasuredMs = Entry.Component->GetAverageTickTimeMs();
+		const float CostMs = MeasuredMs < 0.f ? InitialEstimateMs : MeasuredMs;
+
+		if (Entry.bAlwaysFullRate || PlannedMs + CostMs <= BudgetMs)
+		{
+			Entry.Component->SetUpdatePeriod(1);
+			PlannedMs += CostMs;
+			++NumFullRate;
+			continue;
+		}
+
+		// Slowest rate that still fits what is left, so the more significant meshes get the smoother updates
+		int32 Period = 2;
+		while (Period < MaxPeriod && PlannedMs + CostMs / Period > BudgetMs)
+		{
+			++Period;
+		}
+
+		if (PlannedMs + CostMs / Period > BudgetMs && !Entry.bRendered)
+		{
+			Entry.Component->SetUpdatePeriod(0);
+			++NumStopped;
+			continue;
+		}
+
+		Entry.Component->SetUpdatePeriod(Period);
+		PlannedMs += CostMs / Period;
+		++NumThrottled;
+	}
+
+	SET_FLOAT_STAT(STAT_AnimBudgetPlanned, PlannedMs);
+	SET_DWORD_STAT(STAT_AnimMeshesFullRate, NumFullRate);
+	SET_DWORD_STAT(STAT_AnimMeshesThrottled, NumThrottled);
+	SET_DWORD_STAT(STAT_AnimMeshesStopped, NumStopped);
+}
+
+
+void UAnimBudgetSubsystem::GatherEntries(const FVector& PlayerLocation)
+{
+	const float HiddenScale = CVarAnimBudgetHiddenScale.GetValueOnGameThread();
+
+	Entries.Reset(Components.Num());
+	for (UBudgetedSkeletalMeshComponent* Component : Components)
+	{
+		FAnimBudgetEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.Component = Component;
+		Entry.bRendered = Component->WasRecentlyRendered(0.25f);
+		Entry.bAlwaysFullRate = false;
+
+		const AEnemy* Enemy = Cast<AEnemy>(Component->GetOwner());
+		if (Enemy && !Enemy->bInPool)
+		{
+			Entry.bAlwaysFullRate = Enemy->bAttacking || Enemy->bOverlappingCombatSphere || Enemy->EnemyMovementState == EEnemyMovementState::EMS_Dead;
+		}
+
+		const float Distance = FVector::Dist(Component->GetComponentLocation(), PlayerLocation);
+		Entry.Significance = 1000.f / (1000.f + Distance);
+		if (!Entry.bRendered)
+		{
+			Entry.Significance *= HiddenScale;
+		}
+	}
+}
+
+
+bool UAnimBudgetSubsystem::IsTickable() const
+{
+	return Components.Num() > 0;
+}
+
+
+ETickableTickType UAnimBudgetSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UAnimBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimBudgetSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimNotifyState_CancelWindow.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "MainCharacter.h"
+
+
+UAnimNotifyState_CancelWindow::UAnimNotifyState_CancelWindow()
+{
+	bAllowAttack = true;
+	bAllowJump = true;
+	bAllowInteract = false;
+}
+
+
+void UAnimNotifyState_CancelWindow::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
+{
+	AMainCharacter* Main = Cast<AMainCharacter>(MeshComp->GetOwner());
+	if (Main)
+	{
+		Main->OpenCancelWindow(bAllowAttack, bAllowJump, bAllowInteract);
+	}
+}
+
+
+void UAnimNotifyState_CancelWindow::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	AMainCharacter* Main = Cast<AMainCharacter>(MeshComp->GetOwner());
+	if (Main)
+	{
+		Main->CloseCancelWindow();
+	}
+}
+
+
+FString UAnimNotifyState_CancelWindow::GetNotifyName_Implementation() const
+{
+	return TEXT("Cancel Window");
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimNotifyState_HitWindow.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "Weapon.h"
+
+
+UAnimNotifyState_HitWindow::UAnimNotifyState_HitWindow()
+{
+	WindowId = 0;
+	DamageScale = 1.f;
+}
+
+
+void UAnimNotifyState_HitWindow::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
+{
+	AActor* Owner = MeshComp->GetOwner();
+
+	AEnemy* Enemy = Cast<AEnemy>(Owner);
+	if (Enemy)
+	{
+		Enemy->OpenHitWindow(WindowId, DamageScale);
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(Owner);
+	if (Main && Main->GetEquippedWeapon())
+	{
+		Main->GetEquippedWeapon()->OpenHitWindow(WindowId, DamageScale);
+	}
+}
+
+
+void UAnimNotifyState_HitWindow::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	AActor* Owner = MeshComp->GetOwner();
+
+	AEnemy* Enemy = Cast<AEnemy>(Owner);
+	if (Enemy)
+	{
+		Enemy->CloseHitWindow(WindowId);
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(Owner);
+	if (Main && Main->GetEquippedWeapon())
+	{
+		Main->GetEquippedWeapon()->CloseHitWindow(WindowId);
+	}
+}
+
+
+FString UAnimNotifyState_HitWindow::GetNotifyName_Implementation() const
+{
+	return FString::Printf(TEXT("Hit Window %d"), WindowId);
+}
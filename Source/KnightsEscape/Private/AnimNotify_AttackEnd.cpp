@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimNotify_AttackEnd.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+
+
+void UAnimNotify_AttackEnd::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	AActor* Owner = MeshComp->GetOwner();
+
+	AEnemy* Enemy = Cast<AEnemy>(Owner);
+	if (Enemy)
+	{
+		Enemy->AttackEnd();
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(Owner);
+	if (Main)
+	{
+		Main->AttackEnd();
+	}
+}
+
+
+FString UAnimNotify_AttackEnd::GetNotifyName_Implementation() const
+{
+	return TEXT("Attack End");
+}
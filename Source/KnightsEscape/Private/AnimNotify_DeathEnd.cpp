@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimNotify_DeathEnd.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+
+
+void UAnimNotify_DeathEnd::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	AActor* Owner = MeshComp->GetOwner();
+
+	AEnemy* Enemy = Cast<AEnemy>(Owner);
+	if (Enemy)
+	{
+		Enemy->DeathEnd();
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(Owner);
+	if (Main)
+	{
+		Main->DeathEnd();
+	}
+}
+
+
+FString UAnimNotify_DeathEnd::GetNotifyName_Implementation() const
+{
+	return TEXT("Death End");
+}
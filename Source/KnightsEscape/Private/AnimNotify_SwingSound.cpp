@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimNotify_SwingSound.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundBase.h"
+#include "MainCharacter.h"
+
+
+void UAnimNotify_SwingSound::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	AActor* Owner = MeshComp->GetOwner();
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	if (Sound)
+	{
+		UGameplayStatics::PlaySound2D(Owner, Sound);
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(Owner);
+	if (Main)
+	{
+		Main->PlaySwingSound();
+	}
+}
+
+
+FString UAnimNotify_SwingSound::GetNotifyName_Implementation() const
+{
+	return TEXT("Swing Sound");
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BudgetedSkeletalMeshComponent.h"
+#include "KnightsEscape.h"
+#include "AnimBudgetSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Budgeted Anim Tick Time (ms)"), STAT_BudgetedAnimTickTime, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budgeted Anim Updates"), STAT_BudgetedAnimUpdates, STATGROUP_KnightsEscape);
+
+
+UBudgetedSkeletalMeshComponent::UBudgetedSkeletalMeshComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	UpdatePeriod = 1;
+	UpdatePhase = 0;
+	FramesSinceUpdate = 0;
+	SkippedDeltaTime = 0.f;
+	AverageTickTimeMs = -1.f;
+}
+
+
+void UBudgetedSkeletalMeshComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UAnimBudgetSubsystem* AnimBudget = GetWorld()->GetSubsystem<UAnimBudgetSubsystem>();
+	if (AnimBudget)
+	{
+		AnimBudget->RegisterComponent(this);
+	}
+}
+
+
+void UBudgetedSkeletalMeshComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UAnimBudgetSubsystem* AnimBudget = GetWorld()->GetSubsystem<UAnimBudgetSubsystem>();
+	if (AnimBudget)
+	{
+		AnimBudget->UnregisterComponent(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UBudgetedSkeletalMeshComponent::SetUpdatePeriod(int32 Period)
+{
+	UpdatePeriod = FMath::Max(Period, 0);
+}
+
+
+void UBudgetedSkeletalMeshComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	// A stopped mesh holds its pose; it does not bank time to jump ahead with later
+	if (UpdatePeriod == 0)
+	{
+		return;
+	}
+
+	SkippedDeltaTime += DeltaTime;
+	++FramesSinceUpdate;
+	if (UpdatePeriod > 1 && FramesSinceUpdate < UpdatePeriod && (GFrameCounter + UpdatePhase) % UpdatePeriod != 0)
+	{
+		return;
+	}
+	DeltaTime = SkippedDeltaTime;
+	SkippedDeltaTime = 0.f;
+	FramesSinceUpdate = 0;
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const float TickTimeMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+	AverageTickTimeMs = AverageTickTimeMs < 0.f ? TickTimeMs : FMath::Lerp(AverageTickTimeMs, TickTimeMs, 0.1f);
+
+	INC_FLOAT_STAT_BY(STAT_BudgetedAnimTickTime, TickTimeMs);
+	INC_DWORD_STAT(STAT_BudgetedAnimUpdates);
+}
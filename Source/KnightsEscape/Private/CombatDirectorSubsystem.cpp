@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatDirectorSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attack Queue Depth"), STAT_AttackQueueDepth, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attack Tokens In Use"), STAT_AttackTokensInUse, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attack Token Utilisation %"), STAT_AttackTokenUtilisation, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Attacks Started"), STAT_AttacksStarted, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarCombatTokensPerTarget(
+	TEXT("ke.Combat.TokensPerTarget"),
+	2,
+	TEXT("How many enemies may attack the same target at once."));
+
+static TAutoConsoleVariable<int32> CVarCombatMaxAttackStartsPerFrame(
+	TEXT("ke.Combat.MaxAttackStartsPerFrame"),
+	1,
+	TEXT("How many granted enemy attacks may start in a single frame; the rest start on later frames."));
+
+static TAutoConsoleVariable<float> CVarCombatMaxTokenHoldTime(
+	TEXT("ke.Combat.MaxTokenHoldTime"),
+	5.f,
+	TEXT("Seconds after which a token is reclaimed even if the attack never reported its end."));
+
+
+UCombatDirectorSubsystem::UCombatDirectorSubsystem()
+{
+	StartFrame = 0;
+	StartsThisFrame = 0;
+}
+
+
+void UCombatDirectorSubsystem::Deinitialize()
+{
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UCombatDirectorSubsystem::RequestAttack(AEnemy* Enemy, AActor* Target)
+{
+	if (Enemy == nullptr || Target == nullptr)
+	{
+		return;
+	}
+
+	FAttackTokenPool* Pool = Pools.FindByPredicate([Target](const FAttackTokenPool& Candidate) { return Candidate.Target.Get() == Target; });
+	if (Pool == nullptr)
+	{
+		Pool = &Pools.AddDefaulted_GetRef();
+		Pool->Target = Target;
+	}
+
+	const bool bHoldsToken = Pool->Holders.ContainsByPredicate([Enemy](const FAttackTokenHolder& Holder) { return Holder.Enemy == Enemy; });
+	if (!bHoldsToken)
+	{
+		Pool->Waiting.AddUnique(Enemy);
+		GrantTokens(*Pool);
+	}
+}
+
+
+void UCombatDirectorSubsystem::ReleaseAttack(AEnemy* Enemy)
+{
+	for (FAttackTokenPool& Pool : Pools)
+	{
+		Pool.Holders.RemoveAllSwap([Enemy](const FAttackTokenHolder& Holder) { return Holder.Enemy == Enemy; });
+	}
+}
+
+
+void UCombatDirectorSubsystem::CancelAttackRequest(AEnemy* Enemy)
+{
+	for (FAttackTokenPool& Pool : Pools)
+	{
+		// Keep order, the queue is first come first served
+		Pool.Waiting.Remove(Enemy);
+	}
+}
+
+
+void UCombatDirectorSubsystem::RemoveEnemy(AEnemy* Enemy)
+{
+	CancelAttackRequest(Enemy);
+	ReleaseAttack(Enemy);
+}
+
+
+void UCombatDirectorSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float MaxHoldTime = CVarCombatMaxTokenHoldTime.GetValueOnGameThread();
+
+	Pools.RemoveAll([](const FAttackTokenPool& Pool) { return !Pool.Target.IsValid(); });
+
+	// Rotate the starting pool so no target's queue is always served first
+	const int32 NumPools = Pools.Num();
+	const int32 FirstPool = NumPools > 0 ? (int32)(GFrameCounter % NumPools) : 0;
+
+	int32 NumWaiting = 0;
+	int32 NumHolders = 0;
+	for (int32 Offset = 0; Offset < NumPools; ++Offset)
+	{
+		FAttackTokenPool& Pool = Pools[(FirstPool + Offset) % NumPools];
+
+		Pool.Holders.RemoveAllSwap([Now, MaxHoldTime](const FAttackTokenHolder& Holder)
+		{
+			return !Holder.Enemy->Alive() || Now - Holder.GrantTime > MaxHoldTime;
+		});
+
+		GrantTokens(Pool);
+
+		NumWaiting += Pool.Waiting.Num();
+		NumHolders += Pool.Holders.Num();
+	}
+
+	const int32 TotalTokens = NumPools * FMath::Max(CVarCombatTokensPerTarget.GetValueOnGameThread(), 1);
+	SET_DWORD_STAT(STAT_AttackQueueDepth, NumWaiting);
+	SET_DWORD_STAT(STAT_AttackTokensInUse, NumHolders);
+	SET_DWORD_STAT(STAT_AttackTokenUtilisation, TotalTokens > 0 ? NumHolders * 100 / TotalTokens : 0);
+}
+
+
+void UCombatDirectorSubsystem::GrantTokens(FAttackTokenPool& Pool)
+{
+	const int32 TokensPerTarget = CVarCombatTokensPerTarget.GetValueOnGameThread();
+
+	while (Pool.Holders.Num() < TokensPerTarget && Pool.Waiting.Num() > 0 && GetStartBudget() > 0)
+	{
+		AEnemy* Enemy = Pool.Waiting[0];
+		Pool.Waiting.RemoveAt(0);
+
+		FAttackTokenHolder Holder;
+		Holder.Enemy = Enemy;
+		Holder.GrantTime = GetWorld()->GetTimeSeconds();
+		Pool.Holders.Add(Holder);
+
+		Enemy->Attack();
+
+		// The enemy may have lost its target while it waited; give the token straight back
+		if (!Enemy->bAttacking)
+		{
+			Pool.Holders.Pop();
+			continue;
+		}
+
+		++StartsThisFrame;
+		INC_DWORD_STAT(STAT_AttacksStarted);
+	}
+}
+
+
+int32 UCombatDirectorSubsystem::GetStartBudget()
+{
+	if (StartFrame != GFrameCounter)
+	{
+		StartFrame = GFrameCounter;
+		StartsThisFrame = 0;
+	}
+	return CVarCombatMaxAttackStartsPerFrame.GetValueOnGameThread() - StartsThisFrame;
+}
+
+
+bool UCombatDirectorSubsystem::IsTickable() const
+{
+	return Pools.Num() > 0;
+}
+
+
+ETickableTickType UCombatDirectorSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UCombatDirectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatDirectorSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatTargetComponent.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "MainPlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combat Target Update"), STAT_CombatTargetUpdate, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Target Reranks"), STAT_CombatTargetReranks, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combat Target Candidates"), STAT_CombatTargetCandidates, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lock-On Candidates On Screen"), STAT_LockOnCandidatesOnScreen, STATGROUP_KnightsEscape);
+
+
+UCombatTargetComponent::UCombatTargetComponent()
+{
+	// Ticks while there are candidates, after movement so the screen positions are this frame's
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	bNeedsRerank = false;
+
+	ScreenTargetIndex = INDEX_NONE;
+	ScreenCenterIndex = 0;
+}
+
+
+void UCombatTargetComponent::AddCandidate(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || !Enemy->Alive())
+	{
+		return;
+	}
+
+	AMainCharacter* Main = Cast<AMainCharacter>(GetOwner());
+	if (Main == nullptr)
+	{
+		return;
+	}
+	if (Main->EnemyFilter && !Enemy->IsA(Main->EnemyFilter))
+	{
+		return;
+	}
+
+	Candidates.AddUnique(Enemy);
+
+	// Enemies only in aggro range can be locked on to, but don't become the target by themselves
+	AEnemy* Best = BestCandidate.Get();
+	if (Best != Enemy && !bNeedsRerank && IsInCombatRange(Enemy))
+	{
+		const FVector Location = Main->GetActorLocation();
+		if (Best == nullptr || FVector::DistSquared(Enemy->GetActorLocation(), Location) < FVector::DistSquared(Best->GetActorLocation(), Location))
+		{
+			BestCandidate = Enemy;
+		}
+	}
+
+	SetComponentTickEnabled(true);
+}
+
+
+void UCombatTargetComponent::RemoveCandidate(AEnemy* Enemy)
+{
+	if (Candidates.RemoveSwap(Enemy) == 0)
+	{
+		return;
+	}
+
+	if (LockedTarget.Get() == Enemy)
+	{
+		LockedTarget = nullptr;
+	}
+	if (BestCandidate.Get() == Enemy)
+	{
+		BestCandidate = nullptr;
+		bNeedsRerank = true;
+	}
+
+	SetComponentTickEnabled(true);
+}
+
+
+void UCombatTargetComponent::Invalidate()
+{
+	bNeedsRerank = true;
+	SetComponentTickEnabled(true);
+}
+
+
+void UCombatTargetComponent::CycleTarget(int32 Direction)
+{
+	const int32 NumOnScreen = ScreenCandidates.Num();
+	if (NumOnScreen == 0 || Direction == 0)
+	{
+		return;
+	}
+
+	// Step from the current target, or start from the middle of the screen when it is off screen
+	int32 Index;
+	if (ScreenTargetIndex != INDEX_NONE)
+	{
+		Index = ScreenTargetIndex + (Direction > 0 ? 1 : -1);
+	}
+	else
+	{
+		Index = Direction > 0 ? ScreenCenterIndex : ScreenCenterIndex - 1;
+	}
+	Index = (Index + NumOnScreen) % NumOnScreen;
+
+	AEnemy* Enemy = ScreenCandidates[Index].Enemy.Get();
+	if (Enemy == nullptr || !Enemy->Alive())
+	{
+		return;
+	}
+
+	LockedTarget = Enemy;
+	ScreenTargetIndex = Index;
+
+	ApplyTarget();
+	UpdateHealthBar();
+}
+
+
+void UCombatTargetComponent::ClearLock()
+{
+	LockedTarget = nullptr;
+	SetComponentTickEnabled(true);
+}
+
+
+AEnemy* UCombatTargetComponent::GetCurrentTarget() const
+{
+	AEnemy* Locked = LockedTarget.Get();
+	return Locked ? Locked : BestCandidate.Get();
+}
+
+
+void UCombatTargetComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	SCOPE_CYCLE_COUNTER(STAT_CombatTargetUpdate);
+
+	if (bNeedsRerank)
+	{
+		Rerank();
+	}
+	ApplyTarget();
+
+	UpdateScreenCandidates();
+	UpdateHealthBar();
+
+	SET_DWORD_STAT(STAT_CombatTargetCandidates, Candidates.Num());
+	SET_DWORD_STAT(STAT_LockOnCandidatesOnScreen, ScreenCandidates.Num());
+
+	// One last tick after the final candidate leaves has cleared the target and health bar
+	if (Candidates.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+
+void UCombatTargetComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Candidates.Empty();
+	ScreenCandidates.Empty();
+	BestCandidate = nullptr;
+	LockedTarget = nullptr;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UCombatTargetComponent::Rerank()
+{
+	INC_DWORD_STAT(STAT_CombatTargetReranks);
+
+	bNeedsRerank = false;
+	BestCandidate = nullptr;
+
+	const FVector Location = GetOwner()->GetActorLocation();
+	float BestDistanceSquared = MAX_flt;
+
+	for (int32 Index = Candidates.Num() - 1; Index >= 0; --Index)
+	{
+		AEnemy* Enemy = Candidates[Index].Get();
+		if (Enemy == nullptr)
+		{
+			Candidates.RemoveAtSwap(Index);
+			continue;
+		}
+		if (!IsInCombatRange(Enemy))
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Enemy->GetActorLocation(), Location);
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			BestCandidate = Enemy;
+		}
+	}
+}
+
+
+bool UCombatTargetComponent::IsInCombatRange(const AEnemy* Enemy) const
+{
+	return Enemy->bOverlappingCombatSphere && Enemy->CombatTarget == GetOwner();
+}
+
+
+void UCombatTargetComponent::ApplyTarget()
+{
+	AMainCharacter* Main = Cast<AMainCharacter>(GetOwner());
+	if (Main == nullptr)
+	{
+		return;
+	}
+
+	AEnemy* Target = GetCurrentTarget();
+	Main->SetCombatTarget(Target);
+	Main->SetHasCombatTarget(Target != nullptr);
+}
+
+
+void UCombatTargetComponent::UpdateScreenCandidates()
+{
+	ScreenCandidates.Reset();
+	ScreenTargetIndex = INDEX_NONE;
+	ScreenCenterIndex = 0;
+
+	AMainCharacter* Main = Cast<AMainCharacter>(GetOwner());
+	if (Main == nullptr || Main->MainPlayerController == nullptr)
+	{
+		return;
+	}
+	AMainPlayerController* PlayerController = Main->MainPlayerController;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	int32 ViewportWidth = 0;
+	int32 ViewportHeight = 0;
+	PlayerController->GetViewportSize(ViewportWidth, ViewportHeight);
+
+	for (const TWeakObjectPtr<AEnemy>& Candidate : Candidates)
+	{
+		AEnemy* Enemy = Candidate.Get();
+		if (Enemy == nullptr || !Enemy->Alive() || !Enemy->WasRecentlyRendered())
+		{
+			continue;
+		}
+
+		const FVector Location = Enemy->GetActorLocation();
+		FVector2D ScreenPosition;
+		if (!PlayerController->ProjectWorldLocationToScreen(Location, ScreenPosition))
+		{
+			continue;
+		}
+		if (ScreenPosition.X < 0.f || ScreenPosition.Y < 0.f || ScreenPosition.X > ViewportWidth || ScreenPosition.Y > ViewportHeight)
+		{
+			continue;
+		}
+
+		const FVector ViewSpace = ViewRotation.UnrotateVector(Location - ViewLocation);
+
+		FLockOnCandidate& Entry = ScreenCandidates.AddDefaulted_GetRef();
+		Entry.Enemy = Enemy;
+		Entry.ScreenAngle = FMath::RadiansToDegrees(FMath::Atan2(ViewSpace.Y, ViewSpace.X));
+		Entry.ScreenPosition = ScreenPosition;
+	}
+
+	ScreenCandidates.Sort([](const FLockOnCandidate& A, const FLockOnCandidate& B)
+	{
+		return A.ScreenAngle < B.ScreenAngle;
+	});
+
+	AEnemy* Target = GetCurrentTarget();
+	ScreenCenterIndex = ScreenCandidates.Num();
+	for (int32 Index = 0; Index < ScreenCandidates.Num(); ++Index)
+	{
+		if (ScreenCandidates[Index].Enemy.Get() == Target)
+		{
+			ScreenTargetIndex = Index;
+		}
+		if (ScreenCenterIndex == ScreenCandidates.Num() && ScreenCandidates[Index].ScreenAngle >= 0.f)
+		{
+			ScreenCenterIndex = Index;
+		}
+	}
+}
+
+
+void UCombatTargetComponent::UpdateHealthBar()
+{
+	AMainCharacter* Main = Cast<AMainCharacter>(GetOwner());
+	if (Main == nullptr || Main->MainPlayerController == nullptr)
+	{
+		return;
+	}
+	AMainPlayerController* PlayerController = Main->MainPlayerController;
+
+	if (ScreenTargetIndex != INDEX_NONE)
+	{
+		PlayerController->EnemyScreenPosition = ScreenCandidates[ScreenTargetIndex].ScreenPosition;
+		if (!PlayerController->bEnemyHealthBarVisible)
+		{
+			PlayerController->DisplayEnemyHealthBar();
+		}
+	}
+	else if (PlayerController->bEnemyHealthBarVisible)
+	{
+		PlayerController->RemoveEnemyHealthBar();
+	}
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CorpseSubsystem.h"
+#include "KnightsEscape.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses"), STAT_Corpses, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corpses Evicted"), STAT_CorpsesEvicted, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarCorpseMaxCorpses(
+	TEXT("ke.Corpse.MaxCorpses"),
+	24,
+	TEXT("Maximum number of corpses left in the world; the oldest is removed past this. 0 disables corpses."));
+
+
+UCorpseSubsystem::UCorpseSubsystem()
+{
+	CorpseHolder = nullptr;
+}
+
+
+void UCorpseSubsystem::Deinitialize()
+{
+	Corpses.Empty();
+	CorpseHolder = nullptr;
+
+	Super::Deinitialize();
+}
+
+
+bool UCorpseSubsystem::AddCorpse(USkeletalMeshComponent* Mesh)
+{
+	const int32 MaxCorpses = CVarCorpseMaxCorpses.GetValueOnGameThread();
+	if (Mesh == nullptr || Mesh->SkeletalMesh == nullptr || MaxCorpses <= 0)
+	{
+		return false;
+	}
+
+	// Drop corpses above a lowered cap, then recycle the oldest rather than growing past it
+	while (Corpses.Num() > MaxCorpses)
+	{
+		UPoseableMeshComponent* Evicted = Corpses[0];
+		Corpses.RemoveAt(0, 1, false);
+		if (Evicted)
+		{
+			Evicted->DestroyComponent();
+		}
+		INC_DWORD_STAT(STAT_CorpsesEvicted);
+	}
+
+	UPoseableMeshComponent* Corpse = nullptr;
+	if (Corpses.Num() == MaxCorpses)
+	{
+		Corpse = Corpses[0];
+		Corpses.RemoveAt(0, 1, false);
+		INC_DWORD_STAT(STAT_CorpsesEvicted);
+
+		// Overrides from the previous enemy's extra material slots would otherwise stay applied
+		Corpse->EmptyOverrideMaterials();
+	}
+	if (Corpse == nullptr)
+	{
+		Corpse = MakeCorpseComponent();
+		if (Corpse == nullptr)
+		{
+			return false;
+		}
+	}
+
+	Corpse->SetSkeletalMesh(Mesh->SkeletalMesh);
+	for (int32 Index = 0; Index < Mesh->GetNumMaterials(); ++Index)
+	{
+		Corpse->SetMaterial(Index, Mesh->GetMaterial(Index));
+	}
+	Corpse->SetWorldTransform(Mesh->GetComponentTransform());
+	Corpse->CopyPoseFromSkeletalComponent(Mesh);
+
+	Corpses.Add(Corpse);
+
+	SET_DWORD_STAT(STAT_Corpses, Corpses.Num());
+	return true;
+}
+
+
+UPoseableMeshComponent* UCorpseSubsystem::MakeCorpseComponent()
+{
+	if (CorpseHolder == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		CorpseHolder = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+		if (CorpseHolder == nullptr)
+		{
+			return nullptr;
+		}
+
+		USceneComponent* Root = NewObject<USceneComponent>(CorpseHolder, TEXT("Root"));
+		CorpseHolder->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	// Corpses only need to be drawn: no ticking, no collision, no overlaps
+	UPoseableMeshComponent* Corpse = NewObject<UPoseableMeshComponent>(CorpseHolder);
+	Corpse->PrimaryComponentTick.bCanEverTick = false;
+	Corpse->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Corpse->SetGenerateOverlapEvents(false);
+	Corpse->SetupAttachment(CorpseHolder->GetRootComponent());
+	Corpse->RegisterComponent();
+	return Corpse;
+}
@@ -0,0 +1,193 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageQueueSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue Resolve"), STAT_DamageQueueResolve, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Queued"), STAT_HitsQueued, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events Applied"), STAT_DamageEventsApplied, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Feedback Coalesced"), STAT_HitFeedbackCoalesced, STATGROUP_KnightsEscape);
+
+
+void FDamageQueueTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->ResolveHits();
+	}
+}
+
+
+FString FDamageQueueTickFunction::DiagnosticMessage()
+{
+	return TEXT("UDamageQueueSubsystem::ResolveHits");
+}
+
+
+UDamageQueueSubsystem::UDamageQueueSubsystem()
+{
+	// After melee traces and movement have reported their hits for the frame
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.TickGroup = TG_PostUpdateWork;
+	TickFunction.Target = this;
+}
+
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+
+	PendingHits.Empty();
+	ResolvingHits.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UDamageQueueSubsystem::QueueHit(const FQueuedHit& Hit)
+{
+	// Registered with the first hit, once the world has a level to tick in
+	if (!TickFunction.IsTickFunctionRegistered())
+	{
+		ULevel* Level = GetWorld()->PersistentLevel;
+		if (Level == nullptr)
+		{
+			AActor* Causer = Hit.bDestroyCauser ? Hit.Causer.Get() : nullptr;
+			if (Causer)
+			{
+				Causer->Destroy();
+			}
+			return;
+		}
+		TickFunction.RegisterTickFunction(Level);
+	}
+
+	PendingHits.Add(Hit);
+	INC_DWORD_STAT(STAT_HitsQueued);
+}
+
+
+void UDamageQueueSubsystem::ResolveHits()
+{
+	if (PendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DamageQueueResolve);
+
+	Swap(PendingHits, ResolvingHits);
+
+	// Group by target so feedback and damage can be merged per target
+	ResolvingHits.Sort([](const FQueuedHit& A, const FQueuedHit& B)
+	{
+		return A.Target.Get() < B.Target.Get();
+	});
+
+	int32 NumApplied = 0;
+	int32 NumCoalesced = 0;
+
+	int32 GroupStart = 0;
+	while (GroupStart < ResolvingHits.Num())
+	{
+		AActor* Target = ResolvingHits[GroupStart].Target.Get();
+		int32 GroupEnd = GroupStart + 1;
+		while (GroupEnd < ResolvingHits.Num() && ResolvingHits[GroupEnd].Target.Get() == Target)
+		{
+			++GroupEnd;
+		}
+
+		if (Target)
+		{
+			bool bPlayedParticles = false;
+			bool bPlayedSound = false;
+			for (int32 Index = GroupStart; Index < GroupEnd; ++Index)
+			{
+				FQueuedHit& Hit = ResolvingHits[Index];
+				if (Hit.Particles)
+				{
+					if (!bPlayedParticles)
+					{
+						UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Hit.Particles, Hit.Location, FRotator(0.f), true);
+						bPlayedParticles = true;
+					}
+					else
+					{
+						++NumCoalesced;
+					}
+				}
+				if (Hit.Sound)
+				{
+					if (!bPlayedSound)
+					{
+						UGameplayStatics::PlaySound2D(GetWorld(), Hit.Sound);
+						bPlayedSound = true;
+					}
+					else
+					{
+						++NumCoalesced;
+					}
+				}
+
+				// Fold later hits from the same source into this one
+				for (int32 Other = Index + 1; Other < GroupEnd; ++Other)
+				{
+					FQueuedHit& OtherHit = ResolvingHits[Other];
+					if (OtherHit.Damage > 0.f && OtherHit.Causer == Hit.Causer && OtherHit.Instigator == Hit.Instigator && OtherHit.DamageTypeClass == Hit.DamageTypeClass)
+					{
+						Hit.Damage += OtherHit.Damage;
+						OtherHit.Damage = 0.f;
+					}
+				}
+			}
+
+			for (int32 Index = GroupStart; Index < GroupEnd; ++Index)
+			{
+				const FQueuedHit& Hit = ResolvingHits[Index];
+				if (Hit.Damage <= 0.f)
+				{
+					continue;
+				}
+
+				// Death is handled by the first damage event that kills; the rest would only repeat it
+				AEnemy* Enemy = Cast<AEnemy>(Target);
+				AMainCharacter* Main = Cast<AMainCharacter>(Target);
+				if ((Enemy && !Enemy->Alive()) || (Main && !Main->Alive()) || Target->IsPendingKill())
+				{
+					break;
+				}
+
+				UGameplayStatics::ApplyDamage(Target, Hit.Damage, Hit.Instigator.Get(), Hit.Causer.Get(), Hit.DamageTypeClass);
+				++NumApplied;
+			}
+		}
+
+		GroupStart = GroupEnd;
+	}
+
+	for (const FQueuedHit& Hit : ResolvingHits)
+	{
+		AActor* Causer = Hit.bDestroyCauser ? Hit.Causer.Get() : nullptr;
+		if (Causer)
+		{
+			Causer->Destroy();
+		}
+	}
+
+	ResolvingHits.Reset();
+
+	INC_DWORD_STAT_BY(STAT_DamageEventsApplied, NumApplied);
+	INC_DWORD_STAT_BY(STAT_HitFeedbackCoalesced, NumCoalesced);
+}
@@ -2,6 +2,7 @@
 
 
 #include "Enemy.h"
+#include "KnightsEscape.h"
 #include "Components/SphereComponent.h"
 #include "AIController.h"
 #include "MainCharacter.h"
@@ -12,42 +13,94 @@
 #include "Engine/SkeletalMeshSocket.h"
 #include "Sound/SoundCue.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
 #include "TimerManager.h"
 #include "Components/CapsuleComponent.h"
 #include "MainPlayerController.h"
+#include "EnemyRegistrySubsystem.h"
+#include "EnemySignificanceSubsystem.h"
+#include "EnemyFlowFieldSubsystem.h"
+#include "EnemyPathSubsystem.h"
+#include "CombatDirectorSubsystem.h"
+#include "EnemyPoolSubsystem.h"
+#include "EnemyPopulationSubsystem.h"
+#include "EnemyPerceptionSubsystem.h"
+#include "EnemyDecisionSubsystem.h"
+#include "CorpseSubsystem.h"
+#include "EnemyArchetype.h"
+#include "EnemyArchetypeSubsystem.h"
+#include "EnemyCrowdSubsystem.h"
+#include "EnemyMovementComponent.h"
+#include "MeleeTraceComponent.h"
+#include "DamageQueueSubsystem.h"
+#include "CombatTargetComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "AnimationSharingManager.h"
+#include "BudgetedSkeletalMeshComponent.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Enemies Sharing Animation"), STAT_EnemiesSharingAnimation, STATGROUP_KnightsEscape);
 
 
 // Sets default values
-AEnemy::AEnemy()
+AEnemy::AEnemy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer
+		.SetDefaultSubobjectClass<UBudgetedSkeletalMeshComponent>(ACharacter::MeshComponentName)
+		.SetDefaultSubobjectClass<UEnemyMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
- 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Nothing to do per frame natively; Blueprint subclasses that implement Event Tick still get an actor tick
+	PrimaryActorTick.bCanEverTick = false;
 
-	AggroSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AggroSphere"));
-	AggroSphere->SetupAttachment(GetRootComponent());
-	AggroSphere->InitSphereRadius(650.f);
+#if WITH_EDITORONLY_DATA
+	AggroSphere = CreateEditorOnlyDefaultSubobject<USphereComponent>(TEXT("AggroSphere"));
+	if (AggroSphere)
+	{
+		AggroSphere->SetupAttachment(GetRootComponent());
+		AggroSphere->InitSphereRadius(650.f);
+	}
 
-	CombatSphere = CreateDefaultSubobject<USphereComponent>(TEXT("CombatSphere"));
-	CombatSphere->SetupAttachment(GetRootComponent());
-	CombatSphere->InitSphereRadius(100.f);
+	CombatSphere = CreateEditorOnlyDefaultSubobject<USphereComponent>(TEXT("CombatSphere"));
+	if (CombatSphere)
+	{
+		CombatSphere->SetupAttachment(GetRootComponent());
+		CombatSphere->InitSphereRadius(100.f);
+	}
+#endif
 
 	CombatCollision = CreateDefaultSubobject<UBoxComponent>(TEXT("CombatCollisions"));
 	CombatCollision->SetupAttachment(GetMesh(), FName("EnemySocket"));
 
+	MeleeTrace = CreateDefaultSubobject<UMeleeTraceComponent>(TEXT("MeleeTrace"));
+
 	bOverlappingCombatSphere = false;
 
+	EnemyArchetype = nullptr;
 	Health = 75.f;
+
 	MaxHealth = 75.f;
 	Damage = 10.f;
 
 	AttackMinTime = 0.35f;
 	AttackMaxTime = 2.75f;
 
-	EnemyMovementState = EEnemyMovementState::EMS_Idle;
-
 	DeathDelay = 4.f;
 
+	LegacyAggroRadius = 650.f;
+	LegacyCombatRadius = 100.f;
+
+	EnemyMovementState = EEnemyMovementState::EMS_Idle;
+	Significance = EEnemySignificance::ESI_High;
+
 	bHasValidTarget = false;
+	bInPool = false;
+	bAnimationShared = false;
+
+	ActiveHitWindow = INDEX_NONE;
+	HitDamageScale = 1.f;
+
+	AggroTarget = nullptr;
+	NextAttackTime = 0.f;
+	bAttackRequested = false;
 }
 
 // Called when the game starts or when spawned
@@ -56,31 +109,75 @@ void AEnemy::BeginPlay()
 	Super::BeginPlay();
 	
 	AIController = Cast<AAIController>(GetController());
-	
-	AggroSphere->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::AggroSphereOnOverlapBegin);
-	AggroSphere->OnComponentEndOverlap.AddDynamic(this, &AEnemy::AggroSphereOnOverlapEnd);
 
-	CombatSphere->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::CombatSphereOnOverlapBegin);
-	CombatSphere->OnComponentEndOverlap.AddDynamic(this, &AEnemy::CombatSphereOnOverlapEnd);
+#if WITH_EDITORONLY_DATA
+	// The spheres only carry the legacy ranges; proximity is resolved by the registry instead of physics overlaps
+	if (AggroSphere && CombatSphere)
+	{
+		AggroSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		AggroSphere->SetGenerateOverlapEvents(false);
+		CombatSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		CombatSphere->SetGenerateOverlapEvents(false);
+	}
+#endif
+
+	// Blueprint graphs and the health bar widget still read MaxHealth
+	MaxHealth = GetMaxHealth();
+
+	// Legacy enemies start from their authored Health, as they always have
+	if (!UsesLegacyTuning())
+	{
+		Health = MaxHealth;
+	}
 
-	CombatCollision->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::CombatOnOverlapBegin);
-	CombatCollision->OnComponentEndOverlap.AddDynamic(this, &AEnemy::CombatOnOverlapEnd);
+	// Pooled enemies register once they are handed out
+	if (!bInPool)
+	{
+		RegisterWithSubsystems();
+	}
 
+	// Hits come from sweeping the box, so it never needs physics state of its own
 	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	CombatCollision->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
-	CombatCollision->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CombatCollision->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+	CombatCollision->SetGenerateOverlapEvents(false);
+
+	MeleeTrace->SetTraceShape(CombatCollision);
+	MeleeTrace->OnHit.AddUObject(this, &AEnemy::OnMeleeHit);
 
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 }
 
-// Called every frame
-void AEnemy::Tick(float DeltaTime)
+void AEnemy::PostInitializeComponents()
 {
-	Super::Tick(DeltaTime);
+	Super::PostInitializeComponents();
+
+	// Enemy Blueprints tuned before archetypes existed share one archetype per class, built from their defaults
+	if (EnemyArchetype == nullptr && GetWorld() && GetWorld()->IsGameWorld())
+	{
+		UEnemyArchetypeSubsystem* Archetypes = GetWorld()->GetSubsystem<UEnemyArchetypeSubsystem>();
+		if (Archetypes)
+		{
+			EnemyArchetype = Archetypes->GetLegacyArchetype(GetClass());
+		}
+	}
 }
 
+
+#if WITH_EDITOR
+void AEnemy::PreSave(const ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	// Cooked builds have no spheres, so their radii travel in plain properties
+	if (AggroSphere && CombatSphere)
+	{
+		LegacyAggroRadius = AggroSphere->GetScaledSphereRadius();
+		LegacyCombatRadius = CombatSphere->GetScaledSphereRadius();
+	}
+}
+#endif
+
+
 // Called to bind functionality to input
 void AEnemy::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
@@ -89,99 +186,330 @@ void AEnemy::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 }
 
 
-void AEnemy::AggroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult)
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (OtherActor && Alive())
+	UnregisterFromSubsystems(EndPlayReason == EEndPlayReason::Destroyed);
+
+	if (bInPool)
 	{
-		AMainCharacter* Main = Cast<AMainCharacter>(OtherActor);
-		if (Main)
+		UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+		if (Pool)
 		{
-			MoveToTarget(Main);
+			Pool->RemoveEnemy(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void AEnemy::RegisterWithSubsystems()
+{
+	UEnemyRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>();
+	if (Registry)
+	{
+		Registry->RegisterEnemy(this);
+	}
+
+	UEnemySignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UEnemySignificanceSubsystem>();
+	if (SignificanceSubsystem)
+	{
+		SignificanceSubsystem->RegisterEnemy(this);
+	}
+
+	UEnemyPopulationSubsystem* Population = GetWorld()->GetSubsystem<UEnemyPopulationSubsystem>();
+	if (Population)
+	{
+		Population->RegisterEnemy(this);
+	}
+
+	UEnemyDecisionSubsystem* Decisions = GetWorld()->GetSubsystem<UEnemyDecisionSubsystem>();
+	if (Decisions)
+	{
+		Decisions->RegisterEnemy(this);
+	}
+
+	UEnemyCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UEnemyCrowdSubsystem>();
+	if (Crowd)
+	{
+		Crowd->RegisterEnemy(this);
+	}
+
+	SetAnimationShared(true);
+}
+
+
+void AEnemy::UnregisterFromSubsystems(bool bNotifyRangeEnd)
+{
+	UEnemyRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>();
+	if (Registry)
+	{
+		Registry->UnregisterEnemy(this, bNotifyRangeEnd);
+	}
+
+	UEnemySignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UEnemySignificanceSubsystem>();
+	if (SignificanceSubsystem)
+	{
+		SignificanceSubsystem->UnregisterEnemy(this);
+	}
+
+	UEnemyPopulationSubsystem* Population = GetWorld()->GetSubsystem<UEnemyPopulationSubsystem>();
+	if (Population)
+	{
+		Population->UnregisterEnemy(this);
+	}
+
+	UEnemyDecisionSubsystem* Decisions = GetWorld()->GetSubsystem<UEnemyDecisionSubsystem>();
+	if (Decisions)
+	{
+		Decisions->UnregisterEnemy(this);
+	}
+
+	UEnemyCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UEnemyCrowdSubsystem>();
+	if (Crowd)
+	{
+		Crowd->UnregisterEnemy(this);
+	}
+
+	UEnemyFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UEnemyFlowFieldSubsystem>();
+	if (FlowField)
+	{
+		FlowField->RemoveFollower(this);
+	}
+
+	UEnemyPathSubsystem* Paths = GetWorld()->GetSubsystem<UEnemyPathSubsystem>();
+	if (Paths)
+	{
+		Paths->RemoveEnemy(this);
+	}
+
+	UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+	if (Director)
+	{
+		Director->RemoveEnemy(this);
+	}
+
+	UEnemyPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UEnemyPerceptionSubsystem>();
+	if (Perception)
+	{
+		Perception->RemoveEnemy(this);
+	}
+
+	SetAnimationShared(false);
+}
+
+
+void AEnemy::SetAnimationShared(bool bShared)
+{
+	if (bShared == bAnimationShared)
+	{
+		return;
+	}
+
+	if (!bShared)
+	{
+		UAnimationSharingManager* Manager = UAnimationSharingManager::GetManagerForWorld(GetWorld());
+		if (Manager)
+		{
+			Manager->UnregisterActor(this);
 		}
+		bAnimationShared = false;
+		DEC_DWORD_STAT(STAT_EnemiesSharingAnimation);
+		return;
+	}
+
+	UAnimationSharingSetup* SharingSetup = GetEnemyArchetype()->AnimationSharingSetup;
+	if (SharingSetup == nullptr || !UAnimationSharingManager::AnimationSharingEnabled() || GetMesh()->SkeletalMesh == nullptr)
+	{
+		return;
+	}
+
+	// The first enemy in the world sets the manager up; later calls find it already there
+	UAnimationSharingManager::CreateAnimationSharingManager(this, SharingSetup);
+	UAnimationSharingManager* Manager = UAnimationSharingManager::GetManagerForWorld(GetWorld());
+	if (Manager)
+	{
+		Manager->RegisterActorWithSkeletonBP(this, GetMesh()->SkeletalMesh->Skeleton);
+		bAnimationShared = true;
+		INC_DWORD_STAT(STAT_EnemiesSharingAnimation);
 	}
 }
 
 
-void AEnemy::AggroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AEnemy::ReturnToPool()
 {
-	if (OtherActor)
+	bInPool = true;
+	UnregisterFromSubsystems(false);
+
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+	if (AIController)
 	{
-		AMainCharacter* Main = Cast<AMainCharacter>(OtherActor);
-		if (Main)
+		AIController->StopMovement();
+		AIController->ClearFocus(EAIFocusPriority::Gameplay);
+		AIController->GetPathFollowingComponent()->SetComponentTickEnabled(false);
+	}
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->Deactivate();
+
+	GetMesh()->bPauseAnims = true;
+	GetMesh()->bNoSkeletonUpdate = true;
+}
+
+
+void AEnemy::LeavePool(const FVector& Location, const FRotator& Rotation)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+
+	// Start over from the class defaults, as a freshly spawned enemy would
+	const AEnemy* Defaults = GetClass()->GetDefaultObject<AEnemy>();
+	Health = UsesLegacyTuning() ? Defaults->Health : GetMaxHealth();
+	SetEnemyMovementStatus(EEnemyMovementState::EMS_Idle);
+	Significance = EEnemySignificance::ESI_High;
+	bAttacking = false;
+	bOverlappingCombatSphere = false;
+	bHasValidTarget = false;
+	CombatTarget = nullptr;
+	AggroTarget = nullptr;
+	NextAttackTime = 0.f;
+	bAttackRequested = false;
+	ActiveHitWindow = INDEX_NONE;
+	HitDamageScale = 1.f;
+
+	GetCapsuleComponent()->SetCollisionEnabled(Defaults->GetCapsuleComponent()->GetCollisionEnabled());
+	MeleeTrace->EndSwing();
+
+	SetActorEnableCollision(true);
+	SetActorHiddenInGame(false);
+	SetActorTickEnabled(true);
+
+	GetCharacterMovement()->Activate(true);
+	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Walking);
+
+	GetMesh()->bPauseAnims = false;
+	GetMesh()->bNoSkeletonUpdate = false;
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AnimInstance)
+	{
+		AnimInstance->StopAllMontages(0.f);
+	}
+
+	if (AIController == nullptr)
+	{
+		SpawnDefaultController();
+		AIController = Cast<AAIController>(GetController());
+	}
+	if (AIController)
+	{
+		AIController->GetPathFollowingComponent()->SetComponentTickEnabled(true);
+	}
+
+	bInPool = false;
+	RegisterWithSubsystems();
+}
+
+
+void AEnemy::AggroRangeBegin(AMainCharacter* Main)
+{
+	if (Main && Alive())
+	{
+		// The decision pass starts the chase once the player can be seen
+		AggroTarget = Main;
+
+		if (Main->CombatTargetTracker)
 		{
-			bHasValidTarget = false;
-			if (Main->CombatTarget == this)
-			{
-				Main->SetCombatTarget(nullptr);
-			}
-			Main->SetHasCombatTarget(false);
+			Main->CombatTargetTracker->AddCandidate(this);
+		}
+
+		UEnemyPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UEnemyPerceptionSubsystem>();
+		if (Perception)
+		{
+			Perception->WatchTarget(this, Main);
+		}
+	}
+}
+
+
+void AEnemy::AggroRangeEnd(AMainCharacter* Main)
+{
+	if (Main)
+	{
+		UEnemyPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UEnemyPerceptionSubsystem>();
+		if (Perception)
+		{
+			Perception->RemoveEnemy(this);
+		}
 
-			Main->UpdateCombatTarget();
+		if (AggroTarget == Main)
+		{
+			AggroTarget = nullptr;
+		}
 
+		bHasValidTarget = false;
+		if (Main->CombatTargetTracker)
+		{
+			Main->CombatTargetTracker->RemoveCandidate(this);
+		}
+
+		if (Alive())
+		{
 			SetEnemyMovementStatus(EEnemyMovementState::EMS_Idle);
-			if (AIController)
-			{
-				AIController->StopMovement();
-			}
+		}
+		if (AIController)
+		{
+			AIController->StopMovement();
 		}
 	}
 }
 
 
-void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult)
+void AEnemy::CombatRangeBegin(AMainCharacter* Main)
 {
-	if (OtherActor && Alive())
+	if (Main && Alive())
 	{
-		AMainCharacter* Main = Cast<AMainCharacter>(OtherActor);
-		if (Main)
+		bHasValidTarget = true;
+		CombatTarget = Main;
+		bOverlappingCombatSphere = true;
+
+		// Now in combat range, so it may take over as the player's target
+		if (Main->CombatTargetTracker)
 		{
-			bHasValidTarget = true;
-
-			Main->SetCombatTarget(this);
-			Main->SetHasCombatTarget(true);
-			
-			Main->UpdateCombatTarget();
-			
-			CombatTarget = Main;
-			bOverlappingCombatSphere = true;
-
-			// Wait random amount of time before attacking
-			float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
-			GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
+			Main->CombatTargetTracker->AddCandidate(this);
 		}
+
+		// Wait random amount of time before asking to attack
+		NextAttackTime = GetWorld()->GetTimeSeconds() + GetRandomAttackDelay();
 	}
 }
 
 
-void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AEnemy::CombatRangeEnd(AMainCharacter* Main)
 {
-	if (OtherActor && OtherComp)
+	if (Main)
 	{
-		AMainCharacter* Main = Cast<AMainCharacter>(OtherActor);
-		if (Main)
+		bOverlappingCombatSphere = false;
+		if (Alive())
 		{
-			bOverlappingCombatSphere = false;
 			MoveToTarget(Main);
-			CombatTarget = nullptr;
+		}
+		CombatTarget = nullptr;
 
-			if (Main->CombatTarget == this)
-			{
-				Main->SetCombatTarget(nullptr);
-				Main->bHasCombatTarget = false;
-				Main->UpdateCombatTarget();
-			}
+		// Moving away, so another candidate may now be closer
+		if (Main->CombatTarget == this && Main->CombatTargetTracker)
+		{
+			Main->CombatTargetTracker->Invalidate();
+		}
 
-			if (Main->MainPlayerController)
-			{
-				USkeletalMeshComponent* MainMesh = Cast<USkeletalMeshComponent>(OtherComp);
-				if (MainMesh)
-				{
-					Main->MainPlayerController->RemoveEnemyHealthBar();
-				}
-			}
-			
+		bAttackRequested = false;
 
-			GetWorldTimerManager().ClearTimer(AttackTimer);
+		UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+		if (Director)
+		{
+			Director->CancelAttackRequest(this);
 		}
 	}
 }
@@ -191,6 +519,27 @@ void AEnemy::MoveToTarget(AMainCharacter* Target)
 {
 	SetEnemyMovementStatus(EEnemyMovementState::EMS_MoveToTarget);
 
+	// Chasing enemies share one field toward the player instead of each querying its own path
+	UEnemyFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UEnemyFlowFieldSubsystem>();
+	if (FlowField && UEnemyFlowFieldSubsystem::IsEnabled() && FlowField->AddFollower(this, Target))
+	{
+		return;
+	}
+
+	RequestMoveTo(Target);
+}
+
+
+void AEnemy::RequestMoveTo(AMainCharacter* Target)
+{
+	// Path requests go through the shared queue, which reuses this enemy's last path where it can
+	UEnemyPathSubsystem* Paths = GetWorld()->GetSubsystem<UEnemyPathSubsystem>();
+	if (Paths)
+	{
+		Paths->RequestPath(this, Target);
+		return;
+	}
+
 	if (AIController)
 	{
 		FAIMoveRequest AIMoveRequest;
@@ -204,60 +553,85 @@ void AEnemy::MoveToTarget(AMainCharacter* Target)
 }
 
 
-void AEnemy::CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult)
+void AEnemy::OnMeleeHit(const FHitResult& Hit)
 {
-	if (OtherActor)
+	AMainCharacter* Main = Cast<AMainCharacter>(Hit.GetActor());
+	if (Main)
 	{
-		AMainCharacter* Main = Cast<AMainCharacter>(OtherActor);
-		if (Main)
+		UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+		if (DamageQueue == nullptr)
 		{
-			if (Main->HitParticles)
-			{
-				const USkeletalMeshSocket* TipSocket = GetMesh()->GetSocketByName("TipSocket");
-				if (TipSocket)
-				{
-					FVector SocketLocation = TipSocket->GetSocketLocation(GetMesh());
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Main->HitParticles, SocketLocation, FRotator(0.f), false);
-				}
-			}
-
-			if (Main->HitSound)
-			{
-				UGameplayStatics::PlaySound2D(this, Main->HitSound);
-			}
-			if (DamageTypeClass)
-			{
-				UGameplayStatics::ApplyDamage(Main, Damage, AIController, this, DamageTypeClass);
-			}
+			return;
 		}
-	}
-}
 
+		const UEnemyArchetype* Archetype = GetEnemyArchetype();
 
-void AEnemy::CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
-{
+		FQueuedHit QueuedHit;
+		QueuedHit.Target = Main;
+		QueuedHit.Causer = this;
+		QueuedHit.Instigator = AIController;
+		if (Archetype->DamageTypeClass)
+		{
+			QueuedHit.Damage = Archetype->Damage * HitDamageScale;
+			QueuedHit.DamageTypeClass = Archetype->DamageTypeClass;
+		}
+
+		const USkeletalMeshSocket* TipSocket = GetMesh()->GetSocketByName("TipSocket");
+		if (TipSocket)
+		{
+			QueuedHit.Particles = Main->HitParticles;
+			QueuedHit.Location = TipSocket->GetSocketLocation(GetMesh());
+		}
+		QueuedHit.Sound = Main->HitSound;
 
+		DamageQueue->QueueHit(QueuedHit);
+	}
 }
 
 
 void AEnemy::ActivateCollisions()
 {
-	CombatCollision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-	if (BiteSound)
+	MeleeTrace->BeginSwing();
+
+	USoundCue* Bite = GetEnemyArchetype()->BiteSound;
+	if (Bite)
 	{
-		UGameplayStatics::PlaySound2D(this, BiteSound);
+		UGameplayStatics::PlaySound2D(this, Bite);
 	}
 }
 
 
 void AEnemy::DeactivateCollisions()
 {
-	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeleeTrace->EndSwing();
+}
+
+
+void AEnemy::OpenHitWindow(int32 WindowId, float DamageScale)
+{
+	ActiveHitWindow = WindowId;
+	HitDamageScale = DamageScale;
+	ActivateCollisions();
+}
+
+
+void AEnemy::CloseHitWindow(int32 WindowId)
+{
+	if (ActiveHitWindow != WindowId)
+	{
+		return;
+	}
+
+	ActiveHitWindow = INDEX_NONE;
+	HitDamageScale = 1.f;
+	DeactivateCollisions();
 }
 
 
 void AEnemy::Attack()
 {
+	bAttackRequested = false;
+
 	if (Alive() && bHasValidTarget)
 	{
 		if (AIController)
@@ -268,30 +642,88 @@ void AEnemy::Attack()
 		if (!bAttacking)
 		{
 			bAttacking = true;
+
+			// Montages only play on the enemy's own anim instance
+			SetAnimationShared(false);
+
+			UAnimMontage* Montage = GetEnemyArchetype()->CombatMontage;
 			UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 			if (AnimInstance)
 			{
-				AnimInstance->Montage_Play(CombatMontage, 0.9f);
-				AnimInstance->Montage_JumpToSection(FName("Attack"), CombatMontage);
+				AnimInstance->Montage_Play(Montage, 0.9f);
+				AnimInstance->Montage_JumpToSection(FName("Attack"), Montage);
 			}
 		}
-	}	
+	}
+	else
+	{
+		// Try again later rather than asking every frame
+		NextAttackTime = GetWorld()->GetTimeSeconds() + GetRandomAttackDelay();
+	}
+}
+
+
+void AEnemy::RequestAttack()
+{
+	bAttackRequested = true;
+
+	UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+	if (Director && CombatTarget)
+	{
+		Director->RequestAttack(this, CombatTarget);
+		return;
+	}
+
+	Attack();
+}
+
+
+void AEnemy::GiveUpTarget()
+{
+	bHasValidTarget = false;
+	bAttackRequested = false;
+
+	UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+	if (Director)
+	{
+		Director->CancelAttackRequest(this);
+	}
+
+	SetEnemyMovementStatus(EEnemyMovementState::EMS_Idle);
+	if (AIController)
+	{
+		AIController->StopMovement();
+	}
 }
 
 
 void AEnemy::AttackEnd()
 {
 	bAttacking = false;
-	if (bOverlappingCombatSphere)
+
+	if (Alive() && !bInPool)
 	{
-		float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
-		GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
+		SetAnimationShared(true);
 	}
+
+	UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+	if (Director)
+	{
+		Director->ReleaseAttack(this);
+	}
+
+	NextAttackTime = GetWorld()->GetTimeSeconds() + GetRandomAttackDelay();
 }
 
 
 float AEnemy::TakeDamage(float DamageAmount, struct FDamageEvent const &DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
 {
+	// Already dying, so a late hit must not run the death handling again
+	if (!Alive())
+	{
+		return 0.f;
+	}
+
 	if (Health - DamageAmount <= 0.f)
 	{
 		Health -= DamageAmount;
@@ -307,35 +739,107 @@ float AEnemy::TakeDamage(float DamageAmount, struct FDamageEvent const &DamageEv
 
 void AEnemy::Die(AActor* DeathCauser)
 {
+	SetAnimationShared(false);
+
+	UAnimMontage* Montage = GetEnemyArchetype()->CombatMontage;
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-	if (AnimInstance)
+	const bool bPlayingDeath = AnimInstance && Montage && AnimInstance->Montage_Play(Montage, 1.f) > 0.f;
+	if (bPlayingDeath)
 	{
-		AnimInstance->Montage_Play(CombatMontage, 1.f);
-		AnimInstance->Montage_JumpToSection(FName("Death"), CombatMontage);
+		AnimInstance->Montage_JumpToSection(FName("Death"), Montage);
 	}
 
 	SetEnemyMovementStatus(EEnemyMovementState::EMS_Dead);
 
 	// There is no collision when the enemy dies
-	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	AggroSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	CombatSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	MeleeTrace->EndSwing();
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	AMainCharacter* Main = Cast<AMainCharacter>(DeathCauser);
-	if (Main)
+	// Dead enemies leave every player's aggro / combat range, and with it their combat target candidates
+	UEnemyRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UEnemyRegistrySubsystem>();
+	if (Registry)
+	{
+		Registry->UnregisterEnemy(this, true);
+	}
+
+	UCombatDirectorSubsystem* Director = GetWorld()->GetSubsystem<UCombatDirectorSubsystem>();
+	if (Director)
 	{
-		Main->UpdateCombatTarget();
+		Director->RemoveEnemy(this);
+	}
+
+	// Without the death section nothing would fire the DeathEnd notify, and the enemy would never be cleaned up
+	if (!bPlayingDeath)
+	{
+		DeathEnd();
 	}
 }
 
 
 void AEnemy::DeathEnd()
 {
+	// The corpse takes over the final pose, so the enemy itself can go straight back to the pool
+	UCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UCorpseSubsystem>();
+	if (Corpses && Corpses->AddCorpse(GetMesh()))
+	{
+		Disappear();
+		return;
+	}
+
 	GetMesh()->bPauseAnims = true;
 	GetMesh()->bNoSkeletonUpdate = true;
 
-	GetWorldTimerManager().SetTimer(DeathTimer, this, &AEnemy::Disappear, DeathDelay);
+	GetWorldTimerManager().SetTimer(DeathTimer, this, &AEnemy::Disappear, GetEnemyArchetype()->DeathDelay);
+}
+
+
+const UEnemyArchetype* AEnemy::GetEnemyArchetype() const
+{
+	return EnemyArchetype ? EnemyArchetype : GetDefault<UEnemyArchetype>();
+}
+
+
+bool AEnemy::UsesLegacyTuning() const
+{
+	return GetClass()->GetDefaultObject<AEnemy>()->EnemyArchetype == nullptr;
+}
+
+
+float AEnemy::GetLegacyAggroRadius() const
+{
+#if WITH_EDITORONLY_DATA
+	if (AggroSphere)
+	{
+		return AggroSphere->GetScaledSphereRadius();
+	}
+#endif
+	return LegacyAggroRadius;
+}
+
+
+float AEnemy::GetLegacyCombatRadius() const
+{
+#if WITH_EDITORONLY_DATA
+	if (CombatSphere)
+	{
+		return CombatSphere->GetScaledSphereRadius();
+	}
+#endif
+	return LegacyCombatRadius;
+}
+
+
+float AEnemy::GetMaxHealth() const
+{
+	// Class defaults have no archetype yet, but still carry their Blueprint's MaxHealth
+	return EnemyArchetype ? EnemyArchetype->MaxHealth : MaxHealth;
+}
+
+
+float AEnemy::GetRandomAttackDelay() const
+{
+	const UEnemyArchetype* Archetype = GetEnemyArchetype();
+	return FMath::FRandRange(Archetype->AttackMinTime, Archetype->AttackMaxTime);
 }
 
 
@@ -347,5 +851,11 @@ bool AEnemy::Alive()
 
 void AEnemy::Disappear()
 {
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool && Pool->ReleaseEnemy(this))
+	{
+		return;
+	}
+
 	Destroy();
 }
\ No newline at end of file
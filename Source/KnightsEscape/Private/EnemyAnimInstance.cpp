@@ -5,6 +5,26 @@
 #include "Enemy.h"
 
 
+void FEnemyAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: only copy what Update needs out of the pawn
+	const APawn* Pawn = InAnimInstance->TryGetPawnOwner();
+	Velocity = Pawn ? Pawn->GetVelocity() : FVector::ZeroVector;
+}
+
+
+void FEnemyAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	// Worker thread when the anim Blueprint uses multi-threaded update; runs before the graph reads the properties
+	UEnemyAnimInstance* AnimInstance = CastChecked<UEnemyAnimInstance>(GetAnimInstanceObject());
+	AnimInstance->MovementSpeed = FVector(Velocity.X, Velocity.Y, 0.f).Size();
+}
+
+
 void UEnemyAnimInstance::NativeInitializeAnimation()
 {
 	// Pawn will be nullptr the first time
@@ -21,19 +41,4 @@ void UEnemyAnimInstance::NativeInitializeAnimation()
 
 void UEnemyAnimInstance::UpdateAnimationProperties()
 {
-	if (Pawn == nullptr)
-	{
-		Pawn = TryGetPawnOwner();
-		if (Pawn)
-		{
-			Enemy = Cast<AEnemy>(Pawn);
-		}
-	}
-
-	if (Pawn)
-	{
-		FVector Speed = Pawn->GetVelocity();
-		FVector LateralSpeed = FVector(Speed.X, Speed.Y, 0.f);
-		MovementSpeed = LateralSpeed.Size();
-	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyAnimationSharingStateProcessor.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Sharing Idle"), STAT_EnemiesSharingIdle, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Sharing Walk"), STAT_EnemiesSharingWalk, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Sharing Run"), STAT_EnemiesSharingRun, STATGROUP_KnightsEscape);
+
+
+UEnemyAnimationSharingStateProcessor::UEnemyAnimationSharingStateProcessor()
+{
+	WalkSpeed = 10.f;
+	RunSpeed = 250.f;
+}
+
+
+void UEnemyAnimationSharingStateProcessor::ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState, uint8 OnDemandState, bool& bShouldProcess)
+{
+	AEnemy* Enemy = Cast<AEnemy>(InActor);
+	if (Enemy == nullptr)
+	{
+		OutState = CurrentState;
+		return;
+	}
+
+	// Same lateral speed the enemy anim instance feeds its blend space
+	const FVector Velocity = Enemy->GetVelocity();
+	const float MovementSpeed = FVector(Velocity.X, Velocity.Y, 0.f).Size();
+
+	EEnemyAnimationSharingState State = EEnemyAnimationSharingState::EAS_Idle;
+	if (Enemy->GetEnemyMovementStatus() == EEnemyMovementState::EMS_MoveToTarget || MovementSpeed >= WalkSpeed)
+	{
+		State = MovementSpeed >= RunSpeed ? EEnemyAnimationSharingState::EAS_Run : EEnemyAnimationSharingState::EAS_Walk;
+	}
+
+	switch (State)
+	{
+	case EEnemyAnimationSharingState::EAS_Idle:
+		INC_DWORD_STAT(STAT_EnemiesSharingIdle);
+		break;
+	case EEnemyAnimationSharingState::EAS_Walk:
+		INC_DWORD_STAT(STAT_EnemiesSharingWalk);
+		break;
+	default:
+		INC_DWORD_STAT(STAT_EnemiesSharingRun);
+		break;
+	}
+
+	OutState = (int32)State;
+	bShouldProcess = true;
+}
+
+
+UEnum* UEnemyAnimationSharingStateProcessor::GetAnimationStateEnum_Implementation()
+{
+	return StaticEnum<EEnemyAnimationSharingState>();
+}
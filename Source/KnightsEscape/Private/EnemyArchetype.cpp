@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyArchetype.h"
+
+
+UEnemyArchetype::UEnemyArchetype()
+{
+	MaxHealth = 75.f;
+	Damage = 10.f;
+
+	AggroRadius = 650.f;
+	CombatRadius = 100.f;
+
+	AttackMinTime = 0.35f;
+	AttackMaxTime = 2.75f;
+
+	DeathDelay = 4.f;
+}
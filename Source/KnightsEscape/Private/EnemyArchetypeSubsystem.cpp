@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyArchetypeSubsystem.h"
+#include "EnemyArchetype.h"
+#include "Enemy.h"
+
+
+void UEnemyArchetypeSubsystem::Deinitialize()
+{
+	LegacyArchetypes.Empty();
+
+	Super::Deinitialize();
+}
+
+
+UEnemyArchetype* UEnemyArchetypeSubsystem::GetLegacyArchetype(UClass* EnemyClass)
+{
+	UEnemyArchetype** Found = LegacyArchetypes.Find(EnemyClass);
+	if (Found)
+	{
+		return *Found;
+	}
+
+	const AEnemy* Defaults = EnemyClass->GetDefaultObject<AEnemy>();
+
+	UEnemyArchetype* Archetype = NewObject<UEnemyArchetype>(this, NAME_None, RF_Transient);
+	Archetype->MaxHealth = Defaults->MaxHealth;
+	Archetype->Damage = Defaults->Damage;
+	Archetype->AggroRadius = Defaults->GetLegacyAggroRadius();
+	Archetype->CombatRadius = Defaults->GetLegacyCombatRadius();
+	Archetype->HitParticles = Defaults->HitParticles;
+	Archetype->HitSound = Defaults->HitSound;
+	Archetype->BiteSound = Defaults->BiteSound;
+	Archetype->CombatMontage = Defaults->CombatMontage;
+	Archetype->AttackMinTime = Defaults->AttackMinTime;
+	Archetype->AttackMaxTime = Defaults->AttackMaxTime;
+	Archetype->DamageTypeClass = Defaults->DamageTypeClass;
+	Archetype->DeathDelay = Defaults->DeathDelay;
+	Archetype->AnimationSharingSetup = Defaults->AnimationSharingSetup;
+
+	LegacyArchetypes.Add(EnemyClass, Archetype);
+	return Archetype;
+}
@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyCrowdSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "EnemyMovementComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Crowd Avoidance"), STAT_EnemyCrowdAvoidance, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Agents Steering"), STAT_CrowdAgentsSteering, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Agents Avoiding"), STAT_CrowdAgentsAvoiding, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarCrowdEnabled(
+	TEXT("ke.Crowd.Enabled"),
+	1,
+	TEXT("Whether chasing enemies steer around each other."));
+
+static TAutoConsoleVariable<float> CVarCrowdNeighbourRadius(
+	TEXT("ke.Crowd.NeighbourRadius"),
+	300.f,
+	TEXT("Grid cell size, and so the furthest distance at which enemies take each other into account."));
+
+static TAutoConsoleVariable<float> CVarCrowdPadding(
+	TEXT("ke.Crowd.Padding"),
+	20.f,
+	TEXT("Extra gap kept between enemy capsules."));
+
+static TAutoConsoleVariable<float> CVarCrowdTimeHorizon(
+	TEXT("ke.Crowd.TimeHorizon"),
+	0.75f,
+	TEXT("Seconds ahead that enemies look for contacts with their neighbours."));
+
+static TAutoConsoleVariable<float> CVarCrowdStrength(
+	TEXT("ke.Crowd.Strength"),
+	1.f,
+	TEXT("Scale of the avoidance velocity relative to the enemy's max speed."));
+
+static TAutoConsoleVariable<int32> CVarCrowdMaxNeighbours(
+	TEXT("ke.Crowd.MaxNeighbours"),
+	8,
+	TEXT("Most neighbours an enemy steers away from per frame."));
+
+
+UEnemyCrowdSubsystem::UEnemyCrowdSubsystem()
+{
+}
+
+
+void UEnemyCrowdSubsystem::Deinitialize()
+{
+	Enemies.Empty();
+	Agents.Empty();
+	Avoidance.Empty();
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyCrowdSubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy)
+	{
+		Enemies.AddUnique(Enemy);
+	}
+}
+
+
+void UEnemyCrowdSubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	if (Enemies.RemoveSingleSwap(Enemy) > 0)
+	{
+		UEnemyMovementComponent* Movement = Cast<UEnemyMovementComponent>(Enemy->GetCharacterMovement());
+		if (Movement)
+		{
+			Movement->SetCrowdVelocity(FVector::ZeroVector);
+		}
+	}
+}
+
+
+void UEnemyCrowdSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyCrowdAvoidance);
+
+	if (CVarCrowdEnabled.GetValueOnGameThread() == 0)
+	{
+		for (AEnemy* Enemy : Enemies)
+		{
+			UEnemyMovementComponent* Movement = Cast<UEnemyMovementComponent>(Enemy->GetCharacterMovement());
+			if (Movement)
+			{
+				Movement->SetCrowdVelocity(FVector::ZeroVector);
+			}
+		}
+		return;
+	}
+
+	const float CellSize = FMath::Max(CVarCrowdNeighbourRadius.GetValueOnGameThread(), 1.f);
+	const float Padding = CVarCrowdPadding.GetValueOnGameThread();
+	const float TimeHorizon = CVarCrowdTimeHorizon.GetValueOnGameThread();
+	const float Strength = CVarCrowdStrength.GetValueOnGameThread();
+	const int32 MaxNeighbours = CVarCrowdMaxNeighbours.GetValueOnGameThread();
+
+	GatherAgents(CellSize);
+
+	// Small crowds are cheaper to do inline than to hand to the task graph
+	Avoidance.SetNumUninitialized(Agents.Num());
+	ParallelFor(Agents.Num(), [this, CellSize, Padding, TimeHorizon, MaxNeighbours](int32 Index)
+	{
+		Avoidance[Index] = Agents[Index].bSteering ? ComputeAvoidance(Index, CellSize, Padding, TimeHorizon, MaxNeighbours) : FVector2D::ZeroVector;
+	}, Agents.Num() < 64);
+
+	int32 NumSteering = 0;
+	int32 NumAvoiding = 0;
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		const FCrowdAgent& Agent = Agents[Index];
+		UEnemyMovementComponent* Movement = Cast<UEnemyMovementComponent>(Agent.Enemy->GetCharacterMovement());
+		if (Movement == nullptr)
+		{
+			continue;
+		}
+
+		const FVector2D Velocity = Avoidance[Index] * Strength;
+		Movement->SetCrowdVelocity(FVector(Velocity.X, Velocity.Y, 0.f));
+
+		if (Agent.bSteering)
+		{
+			++NumSteering;
+		}
+		if (!Velocity.IsZero())
+		{
+			++NumAvoiding;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CrowdAgentsSteering, NumSteering);
+	SET_DWORD_STAT(STAT_CrowdAgentsAvoiding, NumAvoiding);
+}
+
+
+void UEnemyCrowdSubsystem::GatherAgents(float CellSize)
+{
+	Agents.Reset(Enemies.Num());
+
+	// Keep the cell arrays between frames, but drop them once the crowd has moved on to other cells
+	if (Cells.Num() > Enemies.Num() * 4)
+	{
+		Cells.Reset();
+	}
+	for (TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (AEnemy* Enemy : Enemies)
+	{
+		// Dead enemies have no collision, so there is nothing to avoid
+		if (!Enemy->Alive())
+		{
+			continue;
+		}
+
+		const FVector Location = Enemy->GetActorLocation();
+		const FVector Velocity = Enemy->GetVelocity();
+		const UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+
+		FCrowdAgent& Agent = Agents.AddDefaulted_GetRef();
+		Agent.Enemy = Enemy;
+		Agent.Position = FVector2D(Location.X, Location.Y);
+		Agent.Velocity = FVector2D(Velocity.X, Velocity.Y);
+		Agent.Radius = Enemy->GetCapsuleComponent()->GetScaledCapsuleRadius();
+		Agent.MaxSpeed = Movement->GetMaxSpeed();
+		Agent.bSteering = Enemy->GetEnemyMovementStatus() == EEnemyMovementState::EMS_MoveToTarget && Movement->IsMovingOnGround();
+
+		Cells.FindOrAdd(GetCell(Agent.Position, CellSize)).Add(Agents.Num() - 1);
+	}
+}
+
+
+FVector2D UEnemyCrowdSubsystem::ComputeAvoidance(int32 Index, float CellSize, float Padding, float TimeHorizon, int32 MaxNeighbours) const
+{
+	const FCrowdAgent& Agent = Agents[Index];
+	const FIntPoint Cell = GetCell(Agent.Position, CellSize);
+
+	FVector2D Result = FVector2D::ZeroVector;
+	int32 NumNeighbours = 0;
+
+	for (int32 Y = -1; Y <= 1 && NumNeighbours < MaxNeighbours; ++Y)
+	{
+		for (int32 X = -1; X <= 1 && NumNeighbours < MaxNeighbours; ++X)
+		{
+			const TArray<int32>* Members = Cells.Find(Cell + FIntPoint(X, Y));
+			if (Members == nullptr)
+			{
+				continue;
+			}
+
+			for (int32 Other : *Members)
+			{
+				if (Other == Index)
+				{
+					continue;
+				}
+
+				const FCrowdAgent& Neighbour = Agents[Other];
+				const float ContactDistance = Agent.Radius + Neighbour.Radius + Padding;
+				const FVector2D Offset = Neighbour.Position - Agent.Position;
+				const FVector2D RelativeVelocity = Agent.Velocity - Neighbour.Velocity;
+
+				// Closest the two get within the horizon if neither changes course
+				const float RelativeSpeedSquared = RelativeVelocity.SizeSquared();
+				const float Time = RelativeSpeedSquared > KINDA_SMALL_NUMBER
+					? FMath::Clamp(FVector2D::DotProduct(Offset, RelativeVelocity) / RelativeSpeedSquared, 0.f, TimeHorizon)
+					: 0.f;
+				const FVector2D Closest = Offset - RelativeVelocity * Time;
+				const float ClosestDistance = Closest.Size();
+				if (ClosestDistance >= ContactDistance)
+				{
+					continue;
+				}
+
+				// Dead centre: sidestep across the agent's own heading, or split the pair apart if it isn't moving
+				FVector2D Away = ClosestDistance > KINDA_SMALL_NUMBER ? Closest / -ClosestDistance : FVector2D(Agent.Velocity.Y, -Agent.Velocity.X).GetSafeNormal();
+				if (Away.IsZero())
+				{
+					Away = FVector2D(Index < Other ? 1.f : -1.f, 0.f);
+				}
+
+				// Deeper and sooner contacts push harder
+				const float Weight = (1.f - ClosestDistance / ContactDistance) * (1.f - Time / (TimeHorizon + KINDA_SMALL_NUMBER));
+				Result += Away * Weight;
+
+				if (++NumNeighbours >= MaxNeighbours)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	const float Size = Result.Size();
+	if (Size > 1.f)
+	{
+		Result /= Size;
+	}
+	return Result * Agent.MaxSpeed;
+}
+
+
+FIntPoint UEnemyCrowdSubsystem::GetCell(const FVector2D& Position, float CellSize) const
+{
+	return FIntPoint(FMath::FloorToInt(Position.X / CellSize), FMath::FloorToInt(Position.Y / CellSize));
+}
+
+
+bool UEnemyCrowdSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0;
+}
+
+
+ETickableTickType UEnemyCrowdSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyCrowdSubsystem, STATGROUP_Tickables);
+}
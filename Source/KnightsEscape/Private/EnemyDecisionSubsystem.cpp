@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyDecisionSubsystem.h"
+#include "KnightsEscape.h"
+#include "MainCharacter.h"
+#include "EnemyPerceptionSubsystem.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Decision Gather"), STAT_EnemyDecisionGather, STATGROUP_KnightsEscape);
+DECLARE_CYCLE_STAT(TEXT("Enemy Decision Evaluate"), STAT_EnemyDecisionEvaluate, STATGROUP_KnightsEscape);
+DECLARE_CYCLE_STAT(TEXT("Enemy Decision Apply"), STAT_EnemyDecisionApply, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Decisions Applied"), STAT_EnemyDecisionsApplied, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarDecisionParallel(
+	TEXT("ke.Decision.Parallel"),
+	1,
+	TEXT("Whether enemy decisions are spread across worker threads; 0 evaluates them on a single worker."));
+
+
+UEnemyDecisionSubsystem::UEnemyDecisionSubsystem()
+{
+	SnapshotTime = 0.f;
+}
+
+
+void UEnemyDecisionSubsystem::Deinitialize()
+{
+	WaitForDecisions();
+
+	Enemies.Empty();
+	RemovedEnemies.Empty();
+	Snapshot.Empty();
+	Decisions.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyDecisionSubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	Enemies.AddUnique(Enemy);
+}
+
+
+void UEnemyDecisionSubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	Enemies.RemoveSingleSwap(Enemy);
+	RemovedEnemies.Add(Enemy);
+}
+
+
+void UEnemyDecisionSubsystem::Tick(float DeltaTime)
+{
+	WaitForDecisions();
+	ApplyDecisions();
+	GatherSnapshot();
+
+	if (Snapshot.Num() == 0)
+	{
+		return;
+	}
+
+	Decisions.SetNumUninitialized(Snapshot.Num());
+
+	const bool bSingleThreaded = CVarDecisionParallel.GetValueOnGameThread() == 0;
+	DecisionTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, bSingleThreaded]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_EnemyDecisionEvaluate);
+
+		const float Now = SnapshotTime;
+		ParallelFor(Snapshot.Num(), [this, Now](int32 Index)
+		{
+			Decisions[Index] = Decide(Snapshot[Index], Now);
+		}, bSingleThreaded);
+	}, TStatId(), nullptr, ENamedThreads::AnyThread);
+}
+
+
+EEnemyDecision UEnemyDecisionSubsystem::Decide(const FEnemyDecisionInput& Input, float Now)
+{
+	if (!Input.bAlive || Input.bAttacking)
+	{
+		return EEnemyDecision::None;
+	}
+
+	// A dead player is no longer worth chasing or biting
+	if (!Input.bTargetAlive)
+	{
+		return Input.State != EEnemyMovementState::EMS_Idle ? EEnemyDecision::Idle : EEnemyDecision::None;
+	}
+
+	if (Input.bInCombatRange)
+	{
+		return !Input.bAttackRequested && Now >= Input.NextAttackTime ? EEnemyDecision::Attack : EEnemyDecision::None;
+	}
+
+	if (Input.AggroTarget && Input.State == EEnemyMovementState::EMS_Idle && Input.bCanSeeAggroTarget)
+	{
+		return EEnemyDecision::MoveToTarget;
+	}
+
+	return EEnemyDecision::None;
+}
+
+
+void UEnemyDecisionSubsystem::WaitForDecisions()
+{
+	if (DecisionTask.IsValid())
+	{
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(DecisionTask);
+		DecisionTask = nullptr;
+	}
+}
+
+
+void UEnemyDecisionSubsystem::ApplyDecisions()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyDecisionApply);
+
+	int32 NumApplied = 0;
+	for (int32 Index = 0; Index < Decisions.Num(); ++Index)
+	{
+		const FEnemyDecisionInput& Input = Snapshot[Index];
+		const EEnemyDecision Decision = Decisions[Index];
+		if (Decision == EEnemyDecision::None || RemovedEnemies.Contains(Input.Enemy))
+		{
+			continue;
+		}
+
+		// Events since the snapshot may have already moved the enemy on; the decision only holds for the state it saw
+		AEnemy* Enemy = Input.Enemy;
+		if (Enemy->GetEnemyMovementStatus() != Input.State || Enemy->bAttacking)
+		{
+			continue;
+		}
+
+		switch (Decision)
+		{
+		case EEnemyDecision::MoveToTarget:
+			if (Enemy->AggroTarget == Input.AggroTarget)
+			{
+				Enemy->MoveToTarget(Input.AggroTarget);
+				++NumApplied;
+			}
+			break;
+		case EEnemyDecision::Attack:
+			if (Enemy->bOverlappingCombatSphere && !Enemy->bAttackRequested)
+			{
+				Enemy->RequestAttack();
+				++NumApplied;
+			}
+			break;
+		case EEnemyDecision::Idle:
+			Enemy->GiveUpTarget();
+			++NumApplied;
+			break;
+		default:
+			break;
+		}
+	}
+
+	Decisions.Reset();
+	RemovedEnemies.Reset();
+
+	SET_DWORD_STAT(STAT_EnemyDecisionsApplied, NumApplied);
+}
+
+
+void UEnemyDecisionSubsystem::GatherSnapshot()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyDecisionGather);
+
+	UEnemyPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UEnemyPerceptionSubsystem>();
+
+	SnapshotTime = GetWorld()->GetTimeSeconds();
+	Snapshot.Reset(Enemies.Num());
+
+	for (AEnemy* Enemy : Enemies)
+	{
+		FEnemyDecisionInput& Input = Snapshot.AddDefaulted_GetRef();
+		Input.Enemy = Enemy;
+		Input.AggroTarget = Enemy->AggroTarget;
+		Input.State = Enemy->GetEnemyMovementStatus();
+		Input.NextAttackTime = Enemy->NextAttackTime;
+		Input.bAlive = Enemy->Alive();
+		Input.bAttacking = Enemy->bAttacking;
+		Input.bAttackRequested = Enemy->bAttackRequested;
+		Input.bInCombatRange = Enemy->bOverlappingCombatSphere && Enemy->CombatTarget;
+		Input.bCanSeeAggroTarget = Input.AggroTarget && (Perception == nullptr || Perception->CanSee(Enemy, Input.AggroTarget));
+
+		AMainCharacter* Target = Enemy->CombatTarget ? Enemy->CombatTarget : Enemy->AggroTarget;
+		Input.bTargetAlive = Target == nullptr || Target->Alive();
+	}
+}
+
+
+bool UEnemyDecisionSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0 || DecisionTask.IsValid();
+}
+
+
+ETickableTickType UEnemyDecisionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyDecisionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyDecisionSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
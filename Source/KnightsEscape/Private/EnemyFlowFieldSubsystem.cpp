@@ -0,0 +1,413 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyFlowFieldSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flow Field Build"), STAT_FlowFieldBuild, STATGROUP_KnightsEscape);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Steering"), STAT_FlowFieldSteering, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Followers"), STAT_FlowFieldFollowers, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flow Field Builds"), STAT_FlowFieldBuilds, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarFlowFieldEnable(
+	TEXT("ke.FlowField.Enable"),
+	1,
+	TEXT("If non-zero, chasing enemies steer along a shared flow field instead of requesting their own paths."));
+
+static TAutoConsoleVariable<float> CVarFlowFieldRebuildInterval(
+	TEXT("ke.FlowField.RebuildInterval"),
+	0.25f,
+	TEXT("Minimum seconds between flow field rebuilds while the player keeps changing cells."));
+
+/** Cardinal neighbour offsets, indexed by edge: +X, -X, +Y, -Y */
+static const FIntPoint EdgeOffsets[4] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+static const int32 OppositeEdges[4] = { 1, 0, 3, 2 };
+
+
+UEnemyFlowFieldSubsystem::UEnemyFlowFieldSubsystem()
+{
+	CellSize = 100.f;
+	WindowRadius = 24;
+	LayerHeight = 200.f;
+	MaxStepHeight = 60.f;
+
+	GoalCell = FIntPoint::ZeroValue;
+	WindowOrigin = FIntPoint::ZeroValue;
+	GoalLayer = 0;
+	bHasField = false;
+	TimeSinceBuild = 0.f;
+	bBoundToNavigation = false;
+}
+
+
+void UEnemyFlowFieldSubsystem::Deinitialize()
+{
+	Followers.Empty();
+	NavCache.Empty();
+	bHasField = false;
+
+	Super::Deinitialize();
+}
+
+
+bool UEnemyFlowFieldSubsystem::IsEnabled()
+{
+	return CVarFlowFieldEnable.GetValueOnGameThread() != 0;
+}
+
+
+bool UEnemyFlowFieldSubsystem::AddFollower(AEnemy* Enemy, AMainCharacter* Target)
+{
+	if (Enemy == nullptr || Target == nullptr)
+	{
+		return false;
+	}
+
+	// One field at a time; enemies chasing anyone else path on their own
+	if (FieldTarget.IsValid() && FieldTarget.Get() != Target)
+	{
+		return false;
+	}
+	if (FieldTarget.Get() != Target)
+	{
+		FieldTarget = Target;
+		bHasField = false;
+	}
+
+	for (FFlowFieldFollower& Follower : Followers)
+	{
+		if (Follower.Enemy == Enemy)
+		{
+			Follower.Target = Target;
+			return true;
+		}
+	}
+
+	// Drop any path the enemy was already following so the two don't fight
+	if (Enemy->AIController)
+	{
+		Enemy->AIController->StopMovement();
+	}
+
+	FFlowFieldFollower& Follower = Followers.AddDefaulted_GetRef();
+	Follower.Enemy = Enemy;
+	Follower.Target = Target;
+	return true;
+}
+
+
+void UEnemyFlowFieldSubsystem::RemoveFollower(AEnemy* Enemy)
+{
+	for (int32 Index = 0; Index < Followers.Num(); ++Index)
+	{
+		if (Followers[Index].Enemy == Enemy)
+		{
+			if (Enemy->AIController)
+			{
+				Enemy->AIController->ClearFocus(EAIFocusPriority::Move);
+			}
+			Followers.RemoveAtSwap(Index);
+			return;
+		}
+	}
+}
+
+
+bool UEnemyFlowFieldSubsystem::SampleDirection(const FVector& Location, FVector& OutDirection) const
+{
+	if (!bHasField)
+	{
+		return false;
+	}
+
+	const int32 Size = GetWindowSize();
+	const FIntPoint Local = GetCell(Location) - WindowOrigin;
+	if (Local.X < 0 || Local.Y < 0 || Local.X >= Size || Local.Y >= Size)
+	{
+		return false;
+	}
+
+	const int32 Index = Local.Y * Size + Local.X;
+	if (Distances[Index] >= BIG_NUMBER)
+	{
+		return false;
+	}
+
+	OutDirection = FVector(Directions[Index], 0.f);
+	return true;
+}
+
+
+void UEnemyFlowFieldSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceBuild += DeltaTime;
+
+	for (int32 Index = Followers.Num() - 1; Index >= 0; --Index)
+	{
+		const FFlowFieldFollower& Follower = Followers[Index];
+		if (!Follower.Target.IsValid() || Follower.Enemy->GetEnemyMovementStatus() != EEnemyMovementState::EMS_MoveToTarget)
+		{
+			RemoveFollower(Follower.Enemy);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FlowFieldFollowers, Followers.Num());
+
+	AMainCharacter* Main = FieldTarget.Get();
+	if (Followers.Num() == 0 || Main == nullptr)
+	{
+		return;
+	}
+
+	// Rebuild when the player reaches a new cell, at most once per rebuild interval
+	const bool bGoalMoved = GetCell(Main->GetActorLocation()) != GoalCell;
+	if (!bHasField || (bGoalMoved && TimeSinceBuild >= CVarFlowFieldRebuildInterval.GetValueOnGameThread()))
+	{
+		BuildField(Main->GetActorLocation());
+		TimeSinceBuild = 0.f;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldSteering);
+
+	for (int32 Index = Followers.Num() - 1; Index >= 0; --Index)
+	{
+		AEnemy* Enemy = Followers[Index].Enemy;
+		AMainCharacter* Target = Followers[Index].Target.Get();
+
+		const FVector Location = Enemy->GetActorLocation();
+		const FVector ToTarget = Target->GetActorLocation() - Location;
+
+		FVector Direction;
+		if (ToTarget.SizeSquared2D() <= FMath::Square(CellSize * 1.5f))
+		{
+			// Close enough that the cell resolution would only get in the way
+			Direction = ToTarget.GetSafeNormal2D();
+		}
+		else if (!SampleDirection(Location, Direction) || Direction.IsNearlyZero())
+		{
+			// Outside the field or cut off from the goal, fall back to a regular path request
+			RemoveFollower(Enemy);
+			Enemy->RequestMoveTo(Target);
+			continue;
+		}
+
+		Enemy->AddMovementInput(Direction, 1.f);
+		if (Enemy->AIController)
+		{
+			Enemy->AIController->SetFocalPoint(Location + Direction * CellSize, EAIFocusPriority::Move);
+		}
+	}
+}
+
+
+void UEnemyFlowFieldSubsystem::BuildField(const FVector& GoalLocation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldBuild);
+	INC_DWORD_STAT(STAT_FlowFieldBuilds);
+
+	bHasField = false;
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (NavData == nullptr)
+	{
+		return;
+	}
+
+	if (!bBoundToNavigation)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &UEnemyFlowFieldSubsystem::OnNavigationGenerationFinished);
+		bBoundToNavigation = true;
+	}
+
+	FNavLocation GoalNavLocation;
+	if (!NavData->ProjectPoint(GoalLocation, GoalNavLocation, FVector(CellSize, CellSize, LayerHeight)))
+	{
+		return;
+	}
+
+	GoalCell = GetCell(GoalNavLocation.Location);
+	GoalLayer = FMath::FloorToInt(GoalNavLocation.Location.Z / LayerHeight);
+
+	// The player is standing here, so trust it even if the cell centre itself missed the navmesh
+	GetNavCell(GoalCell, GoalLayer, *NavData);
+	FFlowFieldNavCell& GoalNavCell = NavCache.FindChecked(FIntVector(GoalCell.X, GoalCell.Y, GoalLayer));
+	if (!GoalNavCell.bWalkable)
+	{
+		GoalNavCell.bWalkable = true;
+		GoalNavCell.Z = GoalNavLocation.Location.Z;
+		GoalNavCell.KnownEdges = 0;
+		GoalNavCell.PassableEdges = 0;
+	}
+
+	const int32 Size = GetWindowSize();
+	WindowOrigin = GoalCell - FIntPoint(WindowRadius, WindowRadius);
+	Distances.Init(BIG_NUMBER, Size * Size);
+	Directions.Init(FVector2D::ZeroVector, Size * Size);
+
+	struct FOpenCell
+	{
+		float Cost;
+		int32 Index;
+	};
+	auto CheaperCell = [](const FOpenCell& A, const FOpenCell& B) { return A.Cost < B.Cost; };
+
+	TArray<FOpenCell> Open;
+
+	auto Relax = [&](const FIntPoint& FromLocal, const FIntPoint& ToLocal, float Cost)
+	{
+		const int32 ToIndex = ToLocal.Y * Size + ToLocal.X;
+		if (Cost < Distances[ToIndex])
+		{
+			Distances[ToIndex] = Cost;
+			Directions[ToIndex] = FVector2D(FromLocal - ToLocal).GetSafeNormal();
+			Open.HeapPush({ Cost, ToIndex }, CheaperCell);
+		}
+	};
+
+	auto InWindow = [Size](const FIntPoint& Local)
+	{
+		return Local.X >= 0 && Local.Y >= 0 && Local.X < Size && Local.Y < Size;
+	};
+
+	const int32 GoalIndex = WindowRadius * Size + WindowRadius;
+	Distances[GoalIndex] = 0.f;
+	Open.HeapPush({ 0.f, GoalIndex }, CheaperCell);
+
+	while (Open.Num() > 0)
+	{
+		FOpenCell Current;
+		Open.HeapPop(Current, CheaperCell);
+		if (Current.Cost > Distances[Current.Index])
+		{
+			continue;
+		}
+
+		const FIntPoint Local(Current.Index % Size, Current.Index / Size);
+		const FIntPoint Cell = WindowOrigin + Local;
+
+		bool bPassable[4];
+		for (int32 Edge = 0; Edge < 4; ++Edge)
+		{
+			const FIntPoint NeighbourLocal = Local + EdgeOffsets[Edge];
+			bPassable[Edge] = InWindow(NeighbourLocal) && IsEdgePassable(Cell, Edge, GoalLayer, *NavData);
+			if (bPassable[Edge])
+			{
+				Relax(Local, NeighbourLocal, Current.Cost + 1.f);
+			}
+		}
+
+		// Diagonals only where both ways around the corner are open, so enemies don't clip wall edges
+		for (int32 EdgeX = 0; EdgeX < 2; ++EdgeX)
+		{
+			for (int32 EdgeY = 2; EdgeY < 4; ++EdgeY)
+			{
+				if (bPassable[EdgeX] && bPassable[EdgeY] &&
+					IsEdgePassable(Cell + EdgeOffsets[EdgeX], EdgeY, GoalLayer, *NavData) &&
+					IsEdgePassable(Cell + EdgeOffsets[EdgeY], EdgeX, GoalLayer, *NavData))
+				{
+					Relax(Local, Local + EdgeOffsets[EdgeX] + EdgeOffsets[EdgeY], Current.Cost + 1.41421356f);
+				}
+			}
+		}
+	}
+
+	bHasField = true;
+}
+
+
+const FFlowFieldNavCell& UEnemyFlowFieldSubsystem::GetNavCell(const FIntPoint& Cell, int32 Layer, const ANavigationData& NavData)
+{
+	const FIntVector Key(Cell.X, Cell.Y, Layer);
+	const FFlowFieldNavCell* Found = NavCache.Find(Key);
+	if (Found)
+	{
+		return *Found;
+	}
+
+	const FVector CellCenter((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, (Layer + 0.5f) * LayerHeight);
+
+	FNavLocation NavLocation;
+	FFlowFieldNavCell NavCell;
+	NavCell.bWalkable = NavData.ProjectPoint(CellCenter, NavLocation, FVector(CellSize * 0.5f, CellSize * 0.5f, LayerHeight));
+	NavCell.Z = NavCell.bWalkable ? NavLocation.Location.Z : CellCenter.Z;
+	NavCell.KnownEdges = 0;
+	NavCell.PassableEdges = 0;
+
+	return NavCache.Add(Key, NavCell);
+}
+
+
+bool UEnemyFlowFieldSubsystem::IsEdgePassable(const FIntPoint& Cell, int32 Edge, int32 Layer, const ANavigationData& NavData)
+{
+	const uint8 EdgeBit = 1 << Edge;
+	const FIntPoint Neighbour = Cell + EdgeOffsets[Edge];
+
+	// Make sure both samples exist before holding references, adding to the cache can move entries
+	GetNavCell(Cell, Layer, NavData);
+	GetNavCell(Neighbour, Layer, NavData);
+	FFlowFieldNavCell& From = NavCache.FindChecked(FIntVector(Cell.X, Cell.Y, Layer));
+	FFlowFieldNavCell& To = NavCache.FindChecked(FIntVector(Neighbour.X, Neighbour.Y, Layer));
+
+	if (From.KnownEdges & EdgeBit)
+	{
+		return (From.PassableEdges & EdgeBit) != 0;
+	}
+
+	bool bPassable = From.bWalkable && To.bWalkable && FMath::Abs(From.Z - To.Z) <= MaxStepHeight;
+	if (bPassable)
+	{
+		const FVector Start((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, From.Z);
+		const FVector End((Neighbour.X + 0.5f) * CellSize, (Neighbour.Y + 0.5f) * CellSize, To.Z);
+		FVector HitLocation;
+		bPassable = !NavData.Raycast(Start, End, HitLocation, NavData.GetDefaultQueryFilter());
+	}
+
+	const uint8 OppositeBit = 1 << OppositeEdges[Edge];
+	From.KnownEdges |= EdgeBit;
+	To.KnownEdges |= OppositeBit;
+	if (bPassable)
+	{
+		From.PassableEdges |= EdgeBit;
+		To.PassableEdges |= OppositeBit;
+	}
+	return bPassable;
+}
+
+
+void UEnemyFlowFieldSubsystem::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	NavCache.Reset();
+	bHasField = false;
+}
+
+
+FIntPoint UEnemyFlowFieldSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+
+bool UEnemyFlowFieldSubsystem::IsTickable() const
+{
+	return Followers.Num() > 0;
+}
+
+
+ETickableTickType UEnemyFlowFieldSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyFlowFieldSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
@@ -0,0 +1,411 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyHorde.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "EnemyPoolSubsystem.h"
+#include "AIController.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Horde Tick"), STAT_EnemyHordeTick, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Horde Members Alive"), STAT_HordeMembersAlive, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Horde Members Promoted"), STAT_HordeMembersPromoted, STATGROUP_KnightsEscape);
+
+
+// Sets default values
+AEnemyHorde::AEnemyHorde()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	SpawningBox = CreateDefaultSubobject<UBoxComponent>(TEXT("SpawningBox"));
+
+	ProxyMesh = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("ProxyMesh"));
+	ProxyMesh->SetupAttachment(GetRootComponent());
+	ProxyMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProxyMesh->SetGenerateOverlapEvents(false);
+	ProxyMesh->SetCastShadow(false);
+
+	HordeSize = 500;
+	MoveSpeed = 300.f;
+	AggroRadius = 6000.f;
+	PromoteDistance = 1200.f;
+	DemoteDistance = 1800.f;
+	MaxPromoted = 8;
+	PromoteCooldown = 3.f;
+	NavChecksPerFrame = 64;
+
+	NumAlive = 0;
+	NextNavCheck = 0;
+}
+
+// Called when the game starts or when spawned
+void AEnemyHorde::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SpawnMembers();
+}
+
+// Called every frame
+void AEnemyHorde::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_EnemyHordeTick);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	APawn* Player = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (Player == nullptr || NumAlive == 0)
+	{
+		return;
+	}
+
+	const FVector PlayerLocation = Player->GetActorLocation();
+	UpdatePromotions(PlayerLocation);
+	Simulate(DeltaTime, PlayerLocation);
+	ConstrainToNavigation();
+	UpdateInstances();
+
+	SET_DWORD_STAT(STAT_HordeMembersAlive, NumAlive);
+	SET_DWORD_STAT(STAT_HordeMembersPromoted, Promoted.Num());
+}
+
+
+void AEnemyHorde::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Hand the fight back to the horde so promoted enemies don't outlive it
+	while (Promoted.Num() > 0)
+	{
+		Demote(Promoted.Num() - 1);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void AEnemyHorde::SpawnMembers()
+{
+	const FVector Origin = SpawningBox->GetComponentLocation();
+	const FVector Extent = SpawningBox->GetScaledBoxExtent();
+	const AEnemy* Defaults = EnemyClass ? EnemyClass->GetDefaultObject<AEnemy>() : GetDefault<AEnemy>();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	PositionX.SetNumUninitialized(HordeSize);
+	PositionY.SetNumUninitialized(HordeSize);
+	PositionZ.SetNumUninitialized(HordeSize);
+	NavPositionX.SetNumUninitialized(HordeSize);
+	NavPositionY.SetNumUninitialized(HordeSize);
+	VelocityX.SetNumZeroed(HordeSize);
+	VelocityY.SetNumZeroed(HordeSize);
+	Health.Init(Defaults->GetMaxHealth(), HordeSize);
+	Cooldown.SetNumZeroed(HordeSize);
+	State.Init(EHordeMemberState::Idle, HordeSize);
+	InstanceTransforms.SetNum(HordeSize);
+
+	ProxyMesh->ClearInstances();
+	for (int32 Member = 0; Member < HordeSize; ++Member)
+	{
+		FVector Location = UKismetMathLibrary::RandomPointInBoundingBox(Origin, Extent);
+
+		FNavLocation NavLocation;
+		if (NavSys && NavSys->ProjectPointToNavigation(Location, NavLocation, FVector(100.f, 100.f, Extent.Z)))
+		{
+			Location = NavLocation.Location;
+		}
+
+		PositionX[Member] = Location.X;
+		PositionY[Member] = Location.Y;
+		PositionZ[Member] = Location.Z;
+		NavPositionX[Member] = Location.X;
+		NavPositionY[Member] = Location.Y;
+
+		InstanceTransforms[Member] = FTransform(FRotator(0.f, FMath::FRandRange(-180.f, 180.f), 0.f), Location);
+		ProxyMesh->AddInstanceWorldSpace(InstanceTransforms[Member]);
+	}
+
+	NumAlive = HordeSize;
+}
+
+
+void AEnemyHorde::Simulate(float DeltaTime, const FVector& PlayerLocation)
+{
+	const int32 Num = State.Num();
+	const float AggroRadiusSquared = FMath::Square(AggroRadius);
+	const float HoldDistanceSquared = FMath::Square(PromoteDistance);
+
+	// Branch-free over flat arrays so the loops vectorise: chase inside the aggro radius and hold at the
+	// edge of promotion range, where the crowd waits for a free slot in the fight
+	for (int32 Member = 0; Member < Num; ++Member)
+	{
+		const float DeltaX = PlayerLocation.X - PositionX[Member];
+		const float DeltaY = PlayerLocation.Y - PositionY[Member];
+		const float DistanceSquared = DeltaX * DeltaX + DeltaY * DeltaY;
+
+		const bool bFree = State[Member] == EHordeMemberState::Idle || State[Member] == EHordeMemberState::Chasing;
+		const float Speed = (bFree && DistanceSquared < AggroRadiusSquared && DistanceSquared > HoldDistanceSquared) ? MoveSpeed : 0.f;
+		const float InvDistance = FMath::InvSqrt(FMath::Max(DistanceSquared, 1.f));
+
+		VelocityX[Member] = DeltaX * InvDistance * Speed;
+		VelocityY[Member] = DeltaY * InvDistance * Speed;
+	}
+
+	for (int32 Member = 0; Member < Num; ++Member)
+	{
+		PositionX[Member] += VelocityX[Member] * DeltaTime;
+		PositionY[Member] += VelocityY[Member] * DeltaTime;
+		Cooldown[Member] = FMath::Max(Cooldown[Member] - DeltaTime, 0.f);
+	}
+
+	for (int32 Member = 0; Member < Num; ++Member)
+	{
+		if (State[Member] == EHordeMemberState::Idle || State[Member] == EHordeMemberState::Chasing)
+		{
+			const bool bMoving = VelocityX[Member] != 0.f || VelocityY[Member] != 0.f;
+			State[Member] = bMoving ? EHordeMemberState::Chasing : EHordeMemberState::Idle;
+		}
+	}
+}
+
+
+void AEnemyHorde::ConstrainToNavigation()
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const int32 Num = State.Num();
+	if (NavSys == nullptr || Num == 0)
+	{
+		return;
+	}
+
+	int32 NumChecked = 0;
+	for (int32 Step = 0; Step < Num && NumChecked < NavChecksPerFrame; ++Step)
+	{
+		const int32 Member = NextNavCheck;
+		NextNavCheck = (NextNavCheck + 1) % Num;
+
+		// Idle members haven't moved since they were last on the navmesh
+		if (State[Member] != EHordeMemberState::Chasing)
+		{
+			continue;
+		}
+		++NumChecked;
+
+		const FVector From(NavPositionX[Member], NavPositionY[Member], PositionZ[Member]);
+		FVector To(PositionX[Member], PositionY[Member], PositionZ[Member]);
+
+		// Stop at walls and ledges crossed since the last check
+		FVector HitLocation;
+		if (UNavigationSystemV1::NavigationRaycast(GetWorld(), From, To, HitLocation))
+		{
+			To = HitLocation;
+		}
+
+		FVector NavLocation;
+		if (!ProjectToNavigation(To, NavLocation))
+		{
+			NavLocation = From;
+		}
+
+		PositionX[Member] = NavLocation.X;
+		PositionY[Member] = NavLocation.Y;
+		PositionZ[Member] = NavLocation.Z;
+		NavPositionX[Member] = NavLocation.X;
+		NavPositionY[Member] = NavLocation.Y;
+	}
+}
+
+
+bool AEnemyHorde::ProjectToNavigation(const FVector& Location, FVector& OutLocation) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+	if (NavSys && NavSys->ProjectPointToNavigation(Location, NavLocation, FVector(100.f, 100.f, 250.f)))
+	{
+		OutLocation = NavLocation.Location;
+		return true;
+	}
+	return false;
+}
+
+
+void AEnemyHorde::UpdatePromotions(const FVector& PlayerLocation)
+{
+	const float DemoteDistanceSquared = FMath::Square(DemoteDistance);
+
+	for (int32 Index = Promoted.Num() - 1; Index >= 0; --Index)
+	{
+		AEnemy* Enemy = Promoted[Index].Enemy.Get();
+		const int32 Member = Promoted[Index].Member;
+
+		// Killed, or taken over by another system; either way the member leaves the horde
+		if (Enemy == nullptr || !Enemy->Alive() || Enemy->bInPool)
+		{
+			State[Member] = EHordeMemberState::Dead;
+			Health[Member] = 0.f;
+			--NumAlive;
+			Promoted.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const bool bInFight = Enemy->bOverlappingCombatSphere || Enemy->bAttacking;
+		if (!bInFight && FVector::DistSquared(Enemy->GetActorLocation(), PlayerLocation) > DemoteDistanceSquared)
+		{
+			Demote(Index);
+		}
+	}
+
+	const int32 FreeSlots = MaxPromoted - Promoted.Num();
+	if (FreeSlots <= 0)
+	{
+		return;
+	}
+
+	// Closest waiting members get the free slots
+	const float PromoteDistanceSquared = FMath::Square(PromoteDistance * 1.05f);
+	TArray<TPair<float, int32>> Candidates;
+	for (int32 Member = 0; Member < State.Num(); ++Member)
+	{
+		if ((State[Member] == EHordeMemberState::Idle || State[Member] == EHordeMemberState::Chasing) && Cooldown[Member] <= 0.f)
+		{
+			const float DistanceSquared = FMath::Square(PositionX[Member] - PlayerLocation.X) + FMath::Square(PositionY[Member] - PlayerLocation.Y);
+			if (DistanceSquared < PromoteDistanceSquared)
+			{
+				Candidates.Emplace(DistanceSquared, Member);
+			}
+		}
+	}
+
+	Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+	for (int32 Index = 0; Index < Candidates.Num() && Index < FreeSlots; ++Index)
+	{
+		Promote(Candidates[Index].Value);
+	}
+}
+
+
+void AEnemyHorde::Promote(int32 Member)
+{
+	if (EnemyClass == nullptr)
+	{
+		return;
+	}
+
+	// The member may have moved since its last navmesh check, so find the ground under it now and fall
+	// back to where it was last known to be on the navmesh
+	FVector Ground(PositionX[Member], PositionY[Member], PositionZ[Member]);
+	if (!ProjectToNavigation(Ground, Ground))
+	{
+		Ground = FVector(NavPositionX[Member], NavPositionY[Member], PositionZ[Member]);
+	}
+
+	// Enemies are placed by their capsule centre
+	const float HalfHeight = EnemyClass->GetDefaultObject<AEnemy>()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FVector Location(Ground.X, Ground.Y, Ground.Z + HalfHeight);
+	const FRotator Rotation = InstanceTransforms[Member].Rotator();
+
+	AEnemy* Enemy = nullptr;
+
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool)
+	{
+		Enemy = Pool->AcquireEnemy(EnemyClass, Location, Rotation);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		Enemy = GetWorld()->SpawnActor<AEnemy>(EnemyClass, Location, Rotation, SpawnParams);
+		if (Enemy)
+		{
+			Enemy->SpawnDefaultController();
+			Enemy->AIController = Cast<AAIController>(Enemy->GetController());
+		}
+	}
+
+	if (Enemy == nullptr)
+	{
+		return;
+	}
+
+	Enemy->Health = Health[Member];
+	State[Member] = EHordeMemberState::Promoted;
+	VelocityX[Member] = 0.f;
+	VelocityY[Member] = 0.f;
+
+	FPromotedHordeMember PromotedMember;
+	PromotedMember.Member = Member;
+	PromotedMember.Enemy = Enemy;
+	Promoted.Add(PromotedMember);
+}
+
+
+void AEnemyHorde::Demote(int32 PromotedIndex)
+{
+	const int32 Member = Promoted[PromotedIndex].Member;
+	AEnemy* Enemy = Promoted[PromotedIndex].Enemy.Get();
+	Promoted.RemoveAtSwap(PromotedIndex);
+
+	if (Enemy == nullptr)
+	{
+		State[Member] = EHordeMemberState::Dead;
+		--NumAlive;
+		return;
+	}
+
+	// Back to standing on the navmesh, from the enemy's capsule centre
+	FVector Location = Enemy->GetActorLocation();
+	Location.Z -= Enemy->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	if (ProjectToNavigation(Location, Location))
+	{
+		NavPositionX[Member] = Location.X;
+		NavPositionY[Member] = Location.Y;
+	}
+	PositionX[Member] = Location.X;
+	PositionY[Member] = Location.Y;
+	PositionZ[Member] = Location.Z;
+	Health[Member] = Enemy->Health;
+	Cooldown[Member] = PromoteCooldown;
+	State[Member] = EHordeMemberState::Idle;
+	InstanceTransforms[Member].SetRotation(FRotator(0.f, Enemy->GetActorRotation().Yaw, 0.f).Quaternion());
+
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool && Pool->ReleaseEnemy(Enemy))
+	{
+		return;
+	}
+	Enemy->Destroy();
+}
+
+
+void AEnemyHorde::UpdateInstances()
+{
+	for (int32 Member = 0; Member < State.Num(); ++Member)
+	{
+		FTransform& Transform = InstanceTransforms[Member];
+
+		// Instances can't be hidden one by one, so promoted and dead members collapse to nothing
+		if (State[Member] == EHordeMemberState::Promoted || State[Member] == EHordeMemberState::Dead)
+		{
+			Transform.SetScale3D(FVector::ZeroVector);
+			continue;
+		}
+
+		Transform.SetLocation(FVector(PositionX[Member], PositionY[Member], PositionZ[Member]));
+		Transform.SetScale3D(FVector::OneVector);
+		if (State[Member] == EHordeMemberState::Chasing)
+		{
+			const float Yaw = FMath::RadiansToDegrees(FMath::Atan2(VelocityY[Member], VelocityX[Member]));
+			Transform.SetRotation(FRotator(0.f, Yaw, 0.f).Quaternion());
+		}
+	}
+
+	ProxyMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyMovementComponent.h"
+
+
+UEnemyMovementComponent::UEnemyMovementComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	CrowdVelocity = FVector::ZeroVector;
+}
+
+
+void UEnemyMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
+{
+	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+
+	if (CrowdVelocity.IsZero() || !IsMovingOnGround())
+	{
+		return;
+	}
+
+	// Only the heading changes; speed stays what path following or input asked for
+	const float Speed = Velocity.Size2D();
+	if (Speed < KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	const FVector Steered = (FVector(Velocity.X, Velocity.Y, 0.f) + CrowdVelocity).GetSafeNormal2D();
+	if (!Steered.IsZero())
+	{
+		Velocity = FVector(Steered.X * Speed, Steered.Y * Speed, Velocity.Z);
+	}
+}
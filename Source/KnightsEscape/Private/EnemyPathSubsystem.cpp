@@ -0,0 +1,276 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPathSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationData.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Issued"), STAT_PathQueriesIssued, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Reused"), STAT_PathQueriesReused, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Spliced"), STAT_PathQueriesSpliced, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Path Queries Deferred"), STAT_PathQueriesDeferred, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarPathMaxQueriesPerFrame(
+	TEXT("ke.Path.MaxQueriesPerFrame"),
+	4,
+	TEXT("Maximum number of new enemy pathfinding queries issued per frame; the rest wait in a queue."));
+
+static TAutoConsoleVariable<float> CVarPathGoalDriftTolerance(
+	TEXT("ke.Path.GoalDriftTolerance"),
+	150.f,
+	TEXT("How far the target may move from a cached path's goal before the path is updated."));
+
+static TAutoConsoleVariable<float> CVarPathSpliceDistance(
+	TEXT("ke.Path.SpliceDistance"),
+	500.f,
+	TEXT("Goal drift up to which a cached path is spliced toward the new goal instead of re-queried."));
+
+
+/** Enemy location followed by the path points still ahead of it, so a reused path doesn't lead back to its start */
+static void GetRemainingPathPoints(const FNavigationPath& Path, const FVector& Location, TArray<FVector>& OutPoints)
+{
+	const TArray<FNavPathPoint>& PathPoints = Path.GetPathPoints();
+
+	int32 Closest = 0;
+	for (int32 Index = 1; Index < PathPoints.Num(); ++Index)
+	{
+		if (FVector::DistSquared(PathPoints[Index].Location, Location) < FVector::DistSquared(PathPoints[Closest].Location, Location))
+		{
+			Closest = Index;
+		}
+	}
+
+	OutPoints.Add(Location);
+	for (int32 Index = Closest + 1; Index < PathPoints.Num(); ++Index)
+	{
+		OutPoints.Add(PathPoints[Index].Location);
+	}
+}
+
+
+void UEnemyPathSubsystem::Deinitialize()
+{
+	Entries.Empty();
+	Queue.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyPathSubsystem::RequestPath(AEnemy* Enemy, AMainCharacter* Target)
+{
+	if (Enemy == nullptr || Target == nullptr || Enemy->AIController == nullptr)
+	{
+		return;
+	}
+
+	FEnemyPathEntry& Entry = Entries.FindOrAdd(Enemy);
+	if (Entry.Target.Get() != Target)
+	{
+		Entry.Path.Reset();
+	}
+	Entry.Target = Target;
+	Entry.bActive = true;
+
+	if (!Entry.bQueued && !TryReusePath(Enemy, Entry))
+	{
+		Enqueue(Enemy, Entry);
+	}
+}
+
+
+void UEnemyPathSubsystem::RemoveEnemy(AEnemy* Enemy)
+{
+	// Any queued query for it is skipped when popped
+	Entries.Remove(Enemy);
+}
+
+
+void UEnemyPathSubsystem::Tick(float DeltaTime)
+{
+	const float Tolerance = CVarPathGoalDriftTolerance.GetValueOnGameThread();
+
+	// Stand-in for goal actor observation: refresh paths whose target drifted too far
+	for (auto& Pair : Entries)
+	{
+		AEnemy* Enemy = Pair.Key;
+		FEnemyPathEntry& Entry = Pair.Value;
+		if (!Entry.bActive || Entry.bQueued)
+		{
+			continue;
+		}
+
+		AMainCharacter* Target = Entry.Target.Get();
+		if (Target == nullptr || Enemy->GetEnemyMovementStatus() != EEnemyMovementState::EMS_MoveToTarget)
+		{
+			// Keep the path around in case the enemy resumes the chase
+			Entry.bActive = false;
+			continue;
+		}
+
+		if (FVector::DistSquared(Target->GetActorLocation(), Entry.PathGoal) > FMath::Square(Tolerance) && !TryReusePath(Enemy, Entry))
+		{
+			Enqueue(Enemy, Entry);
+		}
+	}
+
+	const int32 MaxQueries = CVarPathMaxQueriesPerFrame.GetValueOnGameThread();
+	auto MoreUrgent = [](const FEnemyPathQuery& A, const FEnemyPathQuery& B) { return A.Priority < B.Priority; };
+
+	int32 NumIssued = 0;
+	while (Queue.Num() > 0 && NumIssued < MaxQueries)
+	{
+		FEnemyPathQuery Query;
+		Queue.HeapPop(Query, MoreUrgent);
+
+		FEnemyPathEntry* Entry = Entries.Find(Query.Enemy);
+		if (Entry == nullptr || !Entry->bQueued)
+		{
+			continue;
+		}
+
+		Entry->bQueued = false;
+		if (Entry->bActive && Entry->Target.IsValid() && Query.Enemy->GetEnemyMovementStatus() == EEnemyMovementState::EMS_MoveToTarget)
+		{
+			IssueQuery(Query.Enemy, *Entry);
+			++NumIssued;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_PathQueriesDeferred, Queue.Num());
+}
+
+
+bool UEnemyPathSubsystem::TryReusePath(AEnemy* Enemy, FEnemyPathEntry& Entry)
+{
+	if (!Entry.Path.IsValid() || !Entry.Path->IsValid())
+	{
+		return false;
+	}
+
+	AMainCharacter* Target = Entry.Target.Get();
+	const FVector Goal = Target->GetActorLocation();
+	const FVector Location = Enemy->GetActorLocation();
+	const float DriftSquared = FVector::DistSquared(Goal, Entry.PathGoal);
+	const float Tolerance = CVarPathGoalDriftTolerance.GetValueOnGameThread();
+
+	UPathFollowingComponent* PathFollowing = Enemy->AIController->GetPathFollowingComponent();
+	const bool bFollowingCachedPath = PathFollowing && PathFollowing->GetStatus() == EPathFollowingStatus::Moving && PathFollowing->GetPath() == Entry.Path;
+
+	FAIMoveRequest AIMoveRequest;
+	AIMoveRequest.SetGoalActor(Target);
+	AIMoveRequest.SetAcceptanceRadius(5.f);
+
+	if (DriftSquared <= FMath::Square(Tolerance))
+	{
+		// Path following tracks the goal actor along the last segment, so small drift needs no new path
+		if (!bFollowingCachedPath)
+		{
+			TArray<FVector> Points;
+			GetRemainingPathPoints(*Entry.Path, Location, Points);
+			if (Points.Num() < 2)
+			{
+				Points.Add(Goal);
+			}
+
+			FNavPathSharedPtr ResumedPath = MakeShareable(new FNavigationPath(Points, nullptr));
+			ResumedPath->SetNavigationDataUsed(Entry.Path->GetNavigationDataUsed());
+			Entry.Path = ResumedPath;
+			Enemy->AIController->RequestMove(AIMoveRequest, Entry.Path);
+		}
+		INC_DWORD_STAT(STAT_PathQueriesReused);
+		return true;
+	}
+
+	const ANavigationData* NavData = Entry.Path->GetNavigationDataUsed();
+	if (NavData == nullptr || DriftSquared > FMath::Square(CVarPathSpliceDistance.GetValueOnGameThread()))
+	{
+		return false;
+	}
+
+	// Splice: keep the remaining route and bend its tail toward the new goal if the navmesh allows a straight line
+	TArray<FVector> Points;
+	GetRemainingPathPoints(*Entry.Path, Location, Points);
+
+	FVector HitLocation;
+	const FSharedConstNavQueryFilter QueryFilter = NavData->GetDefaultQueryFilter();
+	if (Points.Num() >= 2 && !NavData->Raycast(Points[Points.Num() - 2], Goal, HitLocation, QueryFilter))
+	{
+		Points.Last() = Goal;
+	}
+	else if (!NavData->Raycast(Points.Last(), Goal, HitLocation, QueryFilter))
+	{
+		Points.Add(Goal);
+	}
+	else
+	{
+		return false;
+	}
+
+	FNavPathSharedPtr SplicedPath = MakeShareable(new FNavigationPath(Points, nullptr));
+	SplicedPath->SetNavigationDataUsed(NavData);
+	Entry.Path = SplicedPath;
+	Entry.PathGoal = Goal;
+	Enemy->AIController->RequestMove(AIMoveRequest, Entry.Path);
+
+	INC_DWORD_STAT(STAT_PathQueriesSpliced);
+	return true;
+}
+
+
+void UEnemyPathSubsystem::Enqueue(AEnemy* Enemy, FEnemyPathEntry& Entry)
+{
+	Entry.bQueued = true;
+
+	FEnemyPathQuery Query;
+	Query.Priority = FVector::DistSquared(Enemy->GetActorLocation(), Entry.Target->GetActorLocation());
+	Query.Enemy = Enemy;
+	Queue.HeapPush(Query, [](const FEnemyPathQuery& A, const FEnemyPathQuery& B) { return A.Priority < B.Priority; });
+}
+
+
+void UEnemyPathSubsystem::IssueQuery(AEnemy* Enemy, FEnemyPathEntry& Entry)
+{
+	AMainCharacter* Target = Entry.Target.Get();
+
+	FAIMoveRequest AIMoveRequest;
+	AIMoveRequest.SetGoalActor(Target);
+	AIMoveRequest.SetAcceptanceRadius(5.f);
+
+	FNavPathSharedPtr NavPath;
+	Enemy->AIController->MoveTo(AIMoveRequest, &NavPath);
+
+	// Repaths are ours to schedule, so stop the path from re-querying whenever the goal actor moves
+	if (NavPath.IsValid())
+	{
+		NavPath->DisableGoalActorObservation();
+	}
+
+	Entry.Path = NavPath;
+	Entry.PathGoal = Target->GetActorLocation();
+
+	INC_DWORD_STAT(STAT_PathQueriesIssued);
+}
+
+
+bool UEnemyPathSubsystem::IsTickable() const
+{
+	return Entries.Num() > 0;
+}
+
+
+ETickableTickType UEnemyPathSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyPathSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyPathSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
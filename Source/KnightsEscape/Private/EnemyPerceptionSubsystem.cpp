@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPerceptionSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Traces Issued"), STAT_SightTracesIssued, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Trace Budget Used %"), STAT_SightTraceBudgetUsed, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sight Entries Watched"), STAT_SightEntriesWatched, STATGROUP_KnightsEscape);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Average Sight Result Age (ms)"), STAT_AverageSightResultAge, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarPerceptionTracesPerFrame(
+	TEXT("ke.Perception.TracesPerFrame"),
+	8,
+	TEXT("Maximum number of enemy line of sight traces started per frame."));
+
+static TAutoConsoleVariable<float> CVarPerceptionResultTTL(
+	TEXT("ke.Perception.ResultTTL"),
+	0.3f,
+	TEXT("Seconds a line of sight result is trusted before the enemy is traced again."));
+
+
+UEnemyPerceptionSubsystem::UEnemyPerceptionSubsystem()
+{
+	NextEntry = 0;
+	NextRequestId = 1;
+
+	TraceDelegate.BindUObject(this, &UEnemyPerceptionSubsystem::OnTraceCompleted);
+}
+
+
+void UEnemyPerceptionSubsystem::Deinitialize()
+{
+	Entries.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyPerceptionSubsystem::WatchTarget(AEnemy* Enemy, AMainCharacter* Target)
+{
+	if (Enemy == nullptr || Target == nullptr)
+	{
+		return;
+	}
+
+	FEnemySightEntry* Entry = Entries.FindByPredicate([Enemy](const FEnemySightEntry& Candidate) { return Candidate.Enemy == Enemy; });
+	if (Entry == nullptr)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Enemy = Enemy;
+	}
+
+	if (Entry->Target.Get() != Target)
+	{
+		Entry->Target = Target;
+		Entry->bVisible = false;
+		Entry->ResultTime = -BIG_NUMBER;
+	}
+}
+
+
+void UEnemyPerceptionSubsystem::RemoveEnemy(AEnemy* Enemy)
+{
+	// A trace still in flight for it finds no entry and is dropped
+	Entries.RemoveAllSwap([Enemy](const FEnemySightEntry& Entry) { return Entry.Enemy == Enemy; });
+}
+
+
+bool UEnemyPerceptionSubsystem::CanSee(const AEnemy* Enemy, const AMainCharacter* Target) const
+{
+	const FEnemySightEntry* Entry = Entries.FindByPredicate([Enemy](const FEnemySightEntry& Candidate) { return Candidate.Enemy == Enemy; });
+	return Entry && Entry->Target.Get() == Target && Entry->bVisible;
+}
+
+
+void UEnemyPerceptionSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float TTL = CVarPerceptionResultTTL.GetValueOnGameThread();
+	const int32 Budget = CVarPerceptionTracesPerFrame.GetValueOnGameThread();
+
+	Entries.RemoveAllSwap([](const FEnemySightEntry& Entry) { return !Entry.Target.IsValid(); });
+
+	// Round-robin, so with more stale entries than budget everyone still gets a turn
+	int32 NumIssued = 0;
+	int32 Step = 0;
+	const int32 NumEntries = Entries.Num();
+	for (; Step < NumEntries && NumIssued < Budget; ++Step)
+	{
+		FEnemySightEntry& Entry = Entries[(NextEntry + Step) % NumEntries];
+		if (!Entry.bPending && Now - Entry.ResultTime > TTL)
+		{
+			IssueTrace(Entry);
+			++NumIssued;
+		}
+	}
+	NextEntry = NumEntries > 0 ? (NextEntry + Step) % NumEntries : 0;
+
+	float TotalAge = 0.f;
+	int32 NumResults = 0;
+	for (const FEnemySightEntry& Entry : Entries)
+	{
+		if (Entry.ResultTime >= 0.f)
+		{
+			TotalAge += Now - Entry.ResultTime;
+			++NumResults;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SightTraceBudgetUsed, Budget > 0 ? NumIssued * 100 / Budget : 0);
+	SET_DWORD_STAT(STAT_SightEntriesWatched, Entries.Num());
+	SET_FLOAT_STAT(STAT_AverageSightResultAge, NumResults > 0 ? TotalAge * 1000.f / NumResults : 0.f);
+}
+
+
+void UEnemyPerceptionSubsystem::IssueTrace(FEnemySightEntry& Entry)
+{
+	AMainCharacter* Target = Entry.Target.Get();
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(EnemyLineOfSight), false, Entry.Enemy);
+	QueryParams.AddIgnoredActor(Target);
+
+	// Other characters don't block sight, only the level does
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Ignore);
+
+	FVector EyeLocation;
+	FRotator EyeRotation;
+	Entry.Enemy->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+	Entry.bPending = true;
+	Entry.RequestId = NextRequestId++;
+	GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyeLocation, Target->GetActorLocation(), ECollisionChannel::ECC_Visibility, QueryParams, ResponseParams, &TraceDelegate, Entry.RequestId);
+
+	INC_DWORD_STAT(STAT_SightTracesIssued);
+}
+
+
+void UEnemyPerceptionSubsystem::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	FEnemySightEntry* Entry = Entries.FindByPredicate([&Datum](const FEnemySightEntry& Candidate) { return Candidate.bPending && Candidate.RequestId == Datum.UserData; });
+	if (Entry == nullptr)
+	{
+		return;
+	}
+
+	Entry->bPending = false;
+	Entry->bVisible = !Datum.OutHits.ContainsByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	Entry->ResultTime = GetWorld()->GetTimeSeconds();
+}
+
+
+bool UEnemyPerceptionSubsystem::IsTickable() const
+{
+	return Entries.Num() > 0;
+}
+
+
+ETickableTickType UEnemyPerceptionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyPerceptionSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPoolSubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Enemies"), STAT_PooledEnemies, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Enemies Reused"), STAT_PooledEnemiesReused, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Enemies Spawned"), STAT_PooledEnemiesSpawned, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<int32> CVarEnemyPoolMaxPerClass(
+	TEXT("ke.EnemyPool.MaxPerClass"),
+	32,
+	TEXT("Maximum number of inactive enemies kept per class; enemies released past this are destroyed."));
+
+
+UEnemyPoolSubsystem::UEnemyPoolSubsystem()
+{
+	NumPooled = 0;
+}
+
+
+void UEnemyPoolSubsystem::Deinitialize()
+{
+	FreeEnemies.Empty();
+	NumPooled = 0;
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyPoolSubsystem::Prewarm(TSubclassOf<AEnemy> EnemyClass, int32 Count, const FVector& Location)
+{
+	if (EnemyClass == nullptr)
+	{
+		return;
+	}
+
+	TArray<AEnemy*>& Free = FreeEnemies.FindOrAdd(EnemyClass);
+	const int32 MaxPerClass = CVarEnemyPoolMaxPerClass.GetValueOnGameThread();
+	for (int32 Index = 0; Index < Count && Free.Num() < MaxPerClass; ++Index)
+	{
+		AEnemy* Enemy = SpawnPooledEnemy(EnemyClass, Location, FRotator(0.f));
+		if (Enemy)
+		{
+			Enemy->ReturnToPool();
+			Free.Add(Enemy);
+			++NumPooled;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_PooledEnemies, NumPooled);
+}
+
+
+AEnemy* UEnemyPoolSubsystem::AcquireEnemy(TSubclassOf<AEnemy> EnemyClass, const FVector& Location, const FRotator& Rotation)
+{
+	if (EnemyClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	AEnemy* Enemy = nullptr;
+
+	TArray<AEnemy*>* Free = FreeEnemies.Find(EnemyClass);
+	if (Free && Free->Num() > 0)
+	{
+		Enemy = Free->Pop(false);
+		--NumPooled;
+		INC_DWORD_STAT(STAT_PooledEnemiesReused);
+	}
+	else
+	{
+		Enemy = SpawnPooledEnemy(EnemyClass, Location, Rotation);
+	}
+
+	if (Enemy)
+	{
+		Enemy->LeavePool(Location, Rotation);
+	}
+
+	SET_DWORD_STAT(STAT_PooledEnemies, NumPooled);
+	return Enemy;
+}
+
+
+bool UEnemyPoolSubsystem::ReleaseEnemy(AEnemy* Enemy)
+{
+	if (Enemy == nullptr)
+	{
+		return false;
+	}
+	if (Enemy->bInPool)
+	{
+		return true;
+	}
+
+	TArray<AEnemy*>& Free = FreeEnemies.FindOrAdd(Enemy->GetClass());
+	if (Free.Num() >= CVarEnemyPoolMaxPerClass.GetValueOnGameThread())
+	{
+		return false;
+	}
+
+	Enemy->ReturnToPool();
+	Free.Add(Enemy);
+	++NumPooled;
+
+	SET_DWORD_STAT(STAT_PooledEnemies, NumPooled);
+	return true;
+}
+
+
+void UEnemyPoolSubsystem::RemoveEnemy(AEnemy* Enemy)
+{
+	TArray<AEnemy*>* Free = FreeEnemies.Find(Enemy->GetClass());
+	if (Free)
+	{
+		NumPooled -= Free->RemoveSwap(Enemy);
+	}
+}
+
+
+int32 UEnemyPoolSubsystem::GetNumPooledEnemies(TSubclassOf<AEnemy> EnemyClass) const
+{
+	const TArray<AEnemy*>* Free = FreeEnemies.Find(EnemyClass);
+	return Free ? Free->Num() : 0;
+}
+
+
+AEnemy* UEnemyPoolSubsystem::SpawnPooledEnemy(TSubclassOf<AEnemy> EnemyClass, const FVector& Location, const FRotator& Rotation)
+{
+	UWorld* World = GetWorld();
+	const FTransform SpawnTransform(Rotation, Location);
+
+	AEnemy* Enemy = World->SpawnActorDeferred<AEnemy>(EnemyClass, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Enemy == nullptr)
+	{
+		return nullptr;
+	}
+
+	// Keeps BeginPlay from registering it with the AI subsystems before it is handed out
+	Enemy->bInPool = true;
+	UGameplayStatics::FinishSpawningActor(Enemy, SpawnTransform);
+
+	Enemy->SpawnDefaultController();
+	Enemy->AIController = Cast<AAIController>(Enemy->GetController());
+
+	INC_DWORD_STAT(STAT_PooledEnemiesSpawned);
+	return Enemy;
+}
\ No newline at end of file
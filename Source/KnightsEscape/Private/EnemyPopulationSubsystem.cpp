@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyPopulationSubsystem.h"
+#include "KnightsEscape.h"
+#include "MainCharacter.h"
+#include "EnemyPoolSubsystem.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Population Tick"), STAT_EnemyPopulationTick, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Enemies"), STAT_LiveEnemies, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Virtual Enemies"), STAT_VirtualEnemies, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<float> CVarPopulationVirtualiseDistance(
+	TEXT("ke.Population.VirtualiseDistance"),
+	6000.f,
+	TEXT("Distance from the player beyond which idle, unseen enemies are turned into records."));
+
+static TAutoConsoleVariable<float> CVarPopulationRehydrateDistance(
+	TEXT("ke.Population.RehydrateDistance"),
+	5000.f,
+	TEXT("Distance from the player within which recorded enemies are brought back; kept below VirtualiseDistance."));
+
+static TAutoConsoleVariable<float> CVarPopulationUpdateInterval(
+	TEXT("ke.Population.UpdateInterval"),
+	0.5f,
+	TEXT("Seconds between scans for enemies to virtualise."));
+
+static TAutoConsoleVariable<int32> CVarPopulationMaxRehydratesPerFrame(
+	TEXT("ke.Population.MaxRehydratesPerFrame"),
+	2,
+	TEXT("Maximum number of recorded enemies brought back in a single frame."));
+
+
+UEnemyPopulationSubsystem::UEnemyPopulationSubsystem()
+{
+	TimeSinceUpdate = 0.f;
+}
+
+
+void UEnemyPopulationSubsystem::Deinitialize()
+{
+	Enemies.Empty();
+	Records.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyPopulationSubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	Enemies.AddUnique(Enemy);
+}
+
+
+void UEnemyPopulationSubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	Enemies.RemoveSingleSwap(Enemy);
+}
+
+
+void UEnemyPopulationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyPopulationTick);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	AMainCharacter* Main = PlayerController ? Cast<AMainCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (Main == nullptr)
+	{
+		return;
+	}
+
+	const FVector Location = Main->GetActorLocation();
+	const float VirtualiseDistance = CVarPopulationVirtualiseDistance.GetValueOnGameThread();
+	const float RehydrateDistance = FMath::Min(CVarPopulationRehydrateDistance.GetValueOnGameThread(), VirtualiseDistance);
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate >= CVarPopulationUpdateInterval.GetValueOnGameThread())
+	{
+		TimeSinceUpdate = 0.f;
+
+		// Enemies that are chasing, fighting or dying stay live wherever they are
+		TArray<AEnemy*> ToVirtualise;
+		for (AEnemy* Enemy : Enemies)
+		{
+			if (Enemy->GetEnemyMovementStatus() == EEnemyMovementState::EMS_Idle
+				&& FVector::DistSquared(Enemy->GetActorLocation(), Location) > FMath::Square(VirtualiseDistance)
+				&& !Enemy->WasRecentlyRendered(1.f))
+			{
+				ToVirtualise.Add(Enemy);
+			}
+		}
+
+		for (AEnemy* Enemy : ToVirtualise)
+		{
+			Virtualise(Enemy);
+		}
+	}
+
+	const int32 MaxRehydrates = CVarPopulationMaxRehydratesPerFrame.GetValueOnGameThread();
+	int32 NumRehydrated = 0;
+	for (int32 Index = Records.Num() - 1; Index >= 0 && NumRehydrated < MaxRehydrates; --Index)
+	{
+		if (FVector::DistSquared(Records[Index].Transform.GetLocation(), Location) < FMath::Square(RehydrateDistance))
+		{
+			Rehydrate(Records[Index]);
+			Records.RemoveAtSwap(Index);
+			++NumRehydrated;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_LiveEnemies, Enemies.Num());
+	SET_DWORD_STAT(STAT_VirtualEnemies, Records.Num());
+}
+
+
+void UEnemyPopulationSubsystem::Virtualise(AEnemy* Enemy)
+{
+	FVirtualEnemyRecord& Record = Records.AddDefaulted_GetRef();
+	Record.EnemyClass = Enemy->GetClass();
+	Record.Transform = Enemy->GetActorTransform();
+	Record.Health = Enemy->Health;
+	Record.EnemyMovementState = Enemy->GetEnemyMovementStatus();
+
+	// Either way the enemy drops out of Enemies through its unregistration
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool && Pool->ReleaseEnemy(Enemy))
+	{
+		return;
+	}
+	Enemy->Destroy();
+}
+
+
+AEnemy* UEnemyPopulationSubsystem::Rehydrate(const FVirtualEnemyRecord& Record)
+{
+	const FVector Location = Record.Transform.GetLocation();
+	const FRotator Rotation = Record.Transform.Rotator();
+
+	AEnemy* Enemy = nullptr;
+
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool)
+	{
+		Enemy = Pool->AcquireEnemy(Record.EnemyClass, Location, Rotation);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Enemy = GetWorld()->SpawnActor<AEnemy>(Record.EnemyClass, Location, Rotation, SpawnParams);
+		if (Enemy)
+		{
+			Enemy->SpawnDefaultController();
+			Enemy->AIController = Cast<AAIController>(Enemy->GetController());
+		}
+	}
+
+	if (Enemy)
+	{
+		Enemy->Health = Record.Health;
+		Enemy->SetEnemyMovementStatus(Record.EnemyMovementState);
+	}
+	return Enemy;
+}
+
+
+bool UEnemyPopulationSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0 || Records.Num() > 0;
+}
+
+
+ETickableTickType UEnemyPopulationSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyPopulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyPopulationSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
@@ -0,0 +1,273 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyRegistrySubsystem.h"
+#include "KnightsEscape.h"
+#include "Enemy.h"
+#include "MainCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "EnemyArchetype.h"
+#include "Components/CapsuleComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Registry Tick"), STAT_EnemyRegistryTick, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Registered Enemies"), STAT_RegisteredEnemies, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies In Aggro Range"), STAT_EnemiesInAggroRange, STATGROUP_KnightsEscape);
+
+
+UEnemyRegistrySubsystem::UEnemyRegistrySubsystem()
+{
+	CellSize = 650.f;
+	MaxAggroRadius = 0.f;
+}
+
+
+void UEnemyRegistrySubsystem::Deinitialize()
+{
+	Enemies.Empty();
+	Cells.Empty();
+	Targets.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemyRegistrySubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || Enemies.Contains(Enemy))
+	{
+		return;
+	}
+
+	FRegisteredEnemy Entry;
+	Entry.Cell = GetCell(Enemy->GetActorLocation());
+	const UEnemyArchetype* Archetype = Enemy->GetEnemyArchetype();
+	Entry.AggroRadius = Archetype->AggroRadius;
+	Entry.CombatRadius = Archetype->CombatRadius;
+
+	MaxAggroRadius = FMath::Max(MaxAggroRadius, Entry.AggroRadius);
+
+	Enemies.Add(Enemy, Entry);
+	AddToCell(Enemy, Entry.Cell);
+}
+
+
+void UEnemyRegistrySubsystem::UnregisterEnemy(AEnemy* Enemy, bool bNotify)
+{
+	FRegisteredEnemy Entry;
+	if (!Enemies.RemoveAndCopyValue(Enemy, Entry))
+	{
+		return;
+	}
+
+	RemoveFromCell(Enemy, Entry.Cell);
+
+	for (FProximityTarget& Target : Targets)
+	{
+		const bool bWasInCombatRange = Target.CombatEnemies.Remove(Enemy) > 0;
+		const bool bWasInAggroRange = Target.AggroEnemies.Remove(Enemy) > 0;
+
+		AMainCharacter* Main = Target.Main.Get();
+		if (bNotify && Main)
+		{
+			if (bWasInCombatRange)
+			{
+				Enemy->CombatRangeEnd(Main);
+			}
+			if (bWasInAggroRange)
+			{
+				Enemy->AggroRangeEnd(Main);
+			}
+		}
+	}
+}
+
+
+void UEnemyRegistrySubsystem::GetEnemiesInAggroRange(const AMainCharacter* Main, TArray<AEnemy*>& OutEnemies, UClass* Filter) const
+{
+	for (const FProximityTarget& Target : Targets)
+	{
+		if (Target.Main.Get() == Main)
+		{
+			for (AEnemy* Enemy : Target.AggroEnemies)
+			{
+				if (Filter == nullptr || Enemy->IsA(Filter))
+				{
+					OutEnemies.Add(Enemy);
+				}
+			}
+			return;
+		}
+	}
+}
+
+
+bool UEnemyRegistrySubsystem::IsInCombatRange(const AEnemy* Enemy, const AMainCharacter* Main) const
+{
+	for (const FProximityTarget& Target : Targets)
+	{
+		if (Target.Main.Get() == Main)
+		{
+			return Target.CombatEnemies.Contains(Enemy);
+		}
+	}
+	return false;
+}
+
+
+void UEnemyRegistrySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyRegistryTick);
+
+	// Re-bucket enemies that crossed into a new cell since last frame
+	for (auto& Pair : Enemies)
+	{
+		const FIntPoint NewCell = GetCell(Pair.Key->GetActorLocation());
+		if (NewCell != Pair.Value.Cell)
+		{
+			RemoveFromCell(Pair.Key, Pair.Value.Cell);
+			AddToCell(Pair.Key, NewCell);
+			Pair.Value.Cell = NewCell;
+		}
+	}
+
+	Targets.RemoveAll([](const FProximityTarget& Target) { return !Target.Main.IsValid(); });
+
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		AMainCharacter* Main = PlayerController ? Cast<AMainCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (Main && !Targets.ContainsByPredicate([Main](const FProximityTarget& Target) { return Target.Main.Get() == Main; }))
+		{
+			FProximityTarget& Target = Targets.AddDefaulted_GetRef();
+			Target.Main = Main;
+		}
+	}
+
+	int32 NumInAggroRange = 0;
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		UpdateTarget(Targets[Index]);
+		NumInAggroRange += Targets[Index].AggroEnemies.Num();
+	}
+
+	SET_DWORD_STAT(STAT_RegisteredEnemies, Enemies.Num());
+	SET_DWORD_STAT(STAT_EnemiesInAggroRange, NumInAggroRange);
+}
+
+
+void UEnemyRegistrySubsystem::UpdateTarget(FProximityTarget& Target)
+{
+	AMainCharacter* Main = Target.Main.Get();
+
+	// Overlaps used to begin as soon as a sphere touched the capsule, so pad the radii by it
+	const FVector Location = Main->GetActorLocation();
+	const float PawnRadius = Main->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	const FIntPoint Center = GetCell(Location);
+	const int32 Ring = FMath::CeilToInt((MaxAggroRadius + PawnRadius) / CellSize);
+
+	NewAggroEnemies.Reset();
+	NewCombatEnemies.Reset();
+
+	for (int32 X = Center.X - Ring; X <= Center.X + Ring; ++X)
+	{
+		for (int32 Y = Center.Y - Ring; Y <= Center.Y + Ring; ++Y)
+		{
+			const TArray<AEnemy*>* Bucket = Cells.Find(FIntPoint(X, Y));
+			if (Bucket == nullptr)
+			{
+				continue;
+			}
+
+			for (AEnemy* Enemy : *Bucket)
+			{
+				const FRegisteredEnemy& Entry = Enemies.FindChecked(Enemy);
+				const float DistanceSquared = FVector::DistSquared(Enemy->GetActorLocation(), Location);
+
+				if (DistanceSquared <= FMath::Square(Entry.AggroRadius + PawnRadius))
+				{
+					NewAggroEnemies.Add(Enemy);
+				}
+				if (DistanceSquared <= FMath::Square(Entry.CombatRadius + PawnRadius))
+				{
+					NewCombatEnemies.Add(Enemy);
+				}
+			}
+		}
+	}
+
+	// Publish the new sets before notifying, so handlers querying the registry see this frame's state.
+	// After the swap the scratch buffers hold last frame's sets.
+	Swap(Target.AggroEnemies, NewAggroEnemies);
+	Swap(Target.CombatEnemies, NewCombatEnemies);
+
+	for (AEnemy* Enemy : NewCombatEnemies)
+	{
+		if (!Target.CombatEnemies.Contains(Enemy))
+		{
+			Enemy->CombatRangeEnd(Main);
+		}
+	}
+	for (AEnemy* Enemy : NewAggroEnemies)
+	{
+		if (!Target.AggroEnemies.Contains(Enemy))
+		{
+			Enemy->AggroRangeEnd(Main);
+		}
+	}
+	for (AEnemy* Enemy : Target.AggroEnemies)
+	{
+		if (!NewAggroEnemies.Contains(Enemy))
+		{
+			Enemy->AggroRangeBegin(Main);
+		}
+	}
+	for (AEnemy* Enemy : Target.CombatEnemies)
+	{
+		if (!NewCombatEnemies.Contains(Enemy))
+		{
+			Enemy->CombatRangeBegin(Main);
+		}
+	}
+}
+
+
+bool UEnemyRegistrySubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0;
+}
+
+
+ETickableTickType UEnemyRegistrySubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemyRegistrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyRegistrySubsystem, STATGROUP_Tickables);
+}
+
+
+FIntPoint UEnemyRegistrySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+
+void UEnemyRegistrySubsystem::AddToCell(AEnemy* Enemy, const FIntPoint& Cell)
+{
+	Cells.FindOrAdd(Cell).Add(Enemy);
+}
+
+
+void UEnemyRegistrySubsystem::RemoveFromCell(AEnemy* Enemy, const FIntPoint& Cell)
+{
+	// Empty buckets are kept so enemies walking back and forth across a border don't reallocate
+	TArray<AEnemy*>* Bucket = Cells.Find(Cell);
+	if (Bucket)
+	{
+		Bucket->RemoveSingleSwap(Enemy);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySignificanceSubsystem.h"
+#include "KnightsEscape.h"
+#include "MainCharacter.h"
+#include "BudgetedSkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Significance Tick"), STAT_EnemySignificanceTick, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies High Significance"), STAT_EnemiesHighSignificance, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Medium Significance"), STAT_EnemiesMediumSignificance, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies Low Significance"), STAT_EnemiesLowSignificance, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies NavWalking"), STAT_EnemiesNavWalking, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<float> CVarSignificanceMediumDistance(
+	TEXT("ke.Significance.MediumDistance"),
+	1500.f,
+	TEXT("Distance from the player beyond which enemies drop to medium significance."));
+
+static TAutoConsoleVariable<float> CVarSignificanceLowDistance(
+	TEXT("ke.Significance.LowDistance"),
+	4000.f,
+	TEXT("Distance from the player beyond which enemies drop to low significance."));
+
+static TAutoConsoleVariable<float> CVarSignificanceHysteresis(
+	TEXT("ke.Significance.Hysteresis"),
+	0.1f,
+	TEXT("Fraction of a tier distance an enemy must move past it before changing tier."));
+
+static TAutoConsoleVariable<float> CVarSignificanceHiddenDistanceScale(
+	TEXT("ke.Significance.HiddenDistanceScale"),
+	2.f,
+	TEXT("Distance multiplier for enemies that have not been rendered recently."));
+
+static TAutoConsoleVariable<float> CVarSignificanceNavWalkingDistance(
+	TEXT("ke.Significance.NavWalkingDistance"),
+	2500.f,
+	TEXT("Distance from the player beyond which enemies walk on the navmesh instead of sweeping for floors; 0 disables."));
+
+static TAutoConsoleVariable<int32> CVarSignificanceNavWalkingIgnorePawns(
+	TEXT("ke.Significance.NavWalkingIgnorePawns"),
+	1,
+	TEXT("Whether navmesh-walking enemies stop colliding with other pawns."));
+
+
+UEnemySignificanceSubsystem::UEnemySignificanceSubsystem()
+{
+	FSignificanceTierSettings& High = TierSettings[(int32)EEnemySignificance::ESI_High];
+	High.ActorTickInterval = 0.f;
+	High.AnimTickInterval = 0.f;
+	High.MovementTickInterval = 0.f;
+	High.VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+	FSignificanceTierSettings& Medium = TierSettings[(int32)EEnemySignificance::ESI_Medium];
+	Medium.ActorTickInterval = 0.1f;
+	Medium.AnimTickInterval = 1.f / 30.f;
+	Medium.MovementTickInterval = 1.f / 30.f;
+	Medium.VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+
+	FSignificanceTierSettings& Low = TierSettings[(int32)EEnemySignificance::ESI_Low];
+	Low.ActorTickInterval = 0.5f;
+	Low.AnimTickInterval = 0.1f;
+	Low.MovementTickInterval = 0.1f;
+	Low.VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+
+	FMemory::Memzero(TierCounts);
+}
+
+
+void UEnemySignificanceSubsystem::Deinitialize()
+{
+	Enemies.Empty();
+
+	Super::Deinitialize();
+}
+
+
+void UEnemySignificanceSubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy)
+	{
+		Enemies.AddUnique(Enemy);
+		ApplyTier(Enemy, Enemy->Significance);
+	}
+}
+
+
+void UEnemySignificanceSubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	Enemies.RemoveSingleSwap(Enemy);
+}
+
+
+void UEnemySignificanceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemySignificanceTick);
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	AMainCharacter* Main = PlayerController ? Cast<AMainCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (Main == nullptr)
+	{
+		return;
+	}
+
+	const FVector Location = Main->GetActorLocation();
+	const float HiddenDistanceScale = CVarSignificanceHiddenDistanceScale.GetValueOnGameThread();
+
+	const float NavWalkingDistance = CVarSignificanceNavWalkingDistance.GetValueOnGameThread();
+	const float Hysteresis = CVarSignificanceHysteresis.GetValueOnGameThread();
+
+	FMemory::Memzero(TierCounts);
+	int32 NumNavWalking = 0;
+
+	for (AEnemy* Enemy : Enemies)
+	{
+		EEnemySignificance Tier = EEnemySignificance::ESI_High;
+		bool bNavWalking = false;
+
+		// Anything in or about to be in a fight keeps full update rates
+		const bool bInCombat = Enemy->bOverlappingCombatSphere || Enemy->GetEnemyMovementStatus() == EEnemyMovementState::EMS_Attacking;
+		if (!bInCombat)
+		{
+			float Distance = FVector::Dist(Enemy->GetActorLocation(), Location);
+			if (!Enemy->WasRecentlyRendered(0.25f))
+			{
+				Distance *= HiddenDistanceScale;
+			}
+			Tier = ComputeTier(Distance, Enemy->Significance);
+
+			const bool bWasNavWalking = Enemy->GetCharacterMovement()->MovementMode == EMovementMode::MOVE_NavWalking;
+			bNavWalking = NavWalkingDistance > 0.f && Enemy->Alive() && Distance > NavWalkingDistance * (bWasNavWalking ? 1.f - Hysteresis : 1.f + Hysteresis);
+		}
+
+		if (Tier != Enemy->Significance)
+		{
+			ApplyTier(Enemy, Tier);
+		}
+		++TierCounts[(int32)Tier];
+
+		ApplyMovementLOD(Enemy, bNavWalking);
+		if (bNavWalking)
+		{
+			++NumNavWalking;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_EnemiesHighSignificance, TierCounts[(int32)EEnemySignificance::ESI_High]);
+	SET_DWORD_STAT(STAT_EnemiesMediumSignificance, TierCounts[(int32)EEnemySignificance::ESI_Medium]);
+	SET_DWORD_STAT(STAT_EnemiesLowSignificance, TierCounts[(int32)EEnemySignificance::ESI_Low]);
+	SET_DWORD_STAT(STAT_EnemiesNavWalking, NumNavWalking);
+}
+
+
+EEnemySignificance UEnemySignificanceSubsystem::ComputeTier(float Distance, EEnemySignificance Current) const
+{
+	// Thresholds[i] is the boundary between tier i and tier i + 1
+	const float Thresholds[] = { CVarSignificanceMediumDistance.GetValueOnGameThread(), CVarSignificanceLowDistance.GetValueOnGameThread() };
+	const float Hysteresis = CVarSignificanceHysteresis.GetValueOnGameThread();
+	const int32 LastTier = (int32)EEnemySignificance::ESI_MAX - 1;
+
+	int32 Tier = (int32)Current;
+	while (Tier < LastTier && Distance > Thresholds[Tier] * (1.f + Hysteresis))
+	{
+		++Tier;
+	}
+	while (Tier > 0 && Distance < Thresholds[Tier - 1] * (1.f - Hysteresis))
+	{
+		--Tier;
+	}
+	return (EEnemySignificance)Tier;
+}
+
+
+void UEnemySignificanceSubsystem::ApplyTier(AEnemy* Enemy, EEnemySignificance Tier)
+{
+	const FSignificanceTierSettings& Settings = TierSettings[(int32)Tier];
+
+	// AEnemy never ticks itself, so this only paces Blueprint subclasses that implement Event Tick
+	Enemy->SetActorTickInterval(Settings.ActorTickInterval);
+
+	// Budgeted meshes get their update rate from UAnimBudgetSubsystem instead
+	USkeletalMeshComponent* Mesh = Enemy->GetMesh();
+	if (!Mesh->IsA<UBudgetedSkeletalMeshComponent>())
+	{
+		Mesh->SetComponentTickInterval(Settings.AnimTickInterval);
+	}
+	Mesh->VisibilityBasedAnimTickOption = Settings.VisibilityBasedAnimTickOption;
+
+	Enemy->GetCharacterMovement()->SetComponentTickInterval(Settings.MovementTickInterval);
+
+	Enemy->Significance = Tier;
+}
+
+
+void UEnemySignificanceSubsystem::ApplyMovementLOD(AEnemy* Enemy, bool bNavWalking)
+{
+	UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+
+	// Only ground movement is swapped; falling and custom modes are left alone
+	if (bNavWalking && Movement->MovementMode == EMovementMode::MOVE_Walking)
+	{
+		Movement->SetMovementMode(EMovementMode::MOVE_NavWalking);
+	}
+	else if (!bNavWalking && Movement->MovementMode == EMovementMode::MOVE_NavWalking)
+	{
+		Movement->SetMovementMode(EMovementMode::MOVE_Walking);
+	}
+
+	const bool bIsNavWalking = Movement->MovementMode == EMovementMode::MOVE_NavWalking;
+	const AEnemy* Defaults = Enemy->GetClass()->GetDefaultObject<AEnemy>();
+	const ECollisionResponse PawnResponse = bIsNavWalking && CVarSignificanceNavWalkingIgnorePawns.GetValueOnGameThread() != 0
+		? ECollisionResponse::ECR_Ignore
+		: Defaults->GetCapsuleComponent()->GetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn);
+
+	UCapsuleComponent* Capsule = Enemy->GetCapsuleComponent();
+	if (Capsule->GetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn) != PawnResponse)
+	{
+		Capsule->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, PawnResponse);
+	}
+}
+
+
+bool UEnemySignificanceSubsystem::IsTickable() const
+{
+	return Enemies.Num() > 0;
+}
+
+
+ETickableTickType UEnemySignificanceSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId UEnemySignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemySignificanceSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
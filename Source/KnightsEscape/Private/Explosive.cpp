@@ -8,6 +8,7 @@
 #include "Sound/SoundCue.h"
 #include "Enemy.h"
 #include "Components/CapsuleComponent.h"
+#include "DamageQueueSubsystem.h"
 
 AExplosive::AExplosive()
 {
@@ -30,15 +31,25 @@ void AExplosive::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor
 			UCapsuleComponent* CapsuleComponent = Cast<UCapsuleComponent>(OtherComp);
 				if (CapsuleComponent)
 				{
-					if (OverlapParticles)
+					UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+					if (DamageQueue)
 					{
-						UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
-					}
-					if (OverlapSound)
-					{
-						UGameplayStatics::PlaySound2D(this, OverlapSound);
+						FQueuedHit QueuedHit;
+						QueuedHit.Target = OtherActor;
+						QueuedHit.Causer = this;
+						QueuedHit.Damage = Damage;
+						QueuedHit.DamageTypeClass = DamageTypeClass;
+						QueuedHit.Particles = OverlapParticles;
+						QueuedHit.Location = GetActorLocation();
+						QueuedHit.Sound = OverlapSound;
+						QueuedHit.bDestroyCauser = true;
+						DamageQueue->QueueHit(QueuedHit);
+
+						// Still the damage causer when the hit resolves, so it only goes out of play until then
+						SetActorHiddenInGame(true);
+						SetActorEnableCollision(false);
+						return;
 					}
-					UGameplayStatics::ApplyDamage(OtherActor, Damage, nullptr, this, DamageTypeClass);
 
 					Destroy();
 				}
@@ -13,6 +13,8 @@
 #include "Weapon.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundCue.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -20,6 +22,15 @@
 #include "MainPlayerController.h"
 #include "SaveGameProgress.h"
 #include "ItemStorage.h"
+#include "CombatTargetComponent.h"
+#include "AnimNotifyState_CancelWindow.h"
+#include "KnightsEscape.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Buffered Inputs Consumed"), STAT_BufferedInputsConsumed, STATGROUP_KnightsEscape);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Buffered Input Delay (ms)"), STAT_BufferedInputDelay, STATGROUP_KnightsEscape);
+
+/** Presses kept at most; older ones are dropped first */
+static const int32 MaxBufferedInputs = 4;
 
 
 // Sets default values
@@ -88,6 +99,17 @@ AMainCharacter::AMainCharacter()
 	bInterpToEnemy = false;
 
 	bHasCombatTarget = false;
+
+	InputBufferTime = 0.35f;
+	DefaultCancelWindowStart = 0.65f;
+
+	ReleaseLockHoldTime = 0.5f;
+	CycleTargetPressTime = 0.f;
+	bCancelWindowAttack = false;
+	bCancelWindowJump = false;
+	bCancelWindowInteract = false;
+
+	CombatTargetTracker = CreateDefaultSubobject<UCombatTargetComponent>(TEXT("CombatTargetTracker"));
 }
 
 // Called when the game starts or when spawned
@@ -236,10 +258,6 @@ void AMainCharacter::Tick(float DeltaTime)
 	if (CombatTarget)
 	{
 		CombatTargetLocation = CombatTarget->GetActorLocation();
-		if (MainPlayerController)
-		{
-			MainPlayerController->EnemyLocation = CombatTargetLocation;
-		}
 	}
 }
 
@@ -277,6 +295,11 @@ void AMainCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 	PlayerInputComponent->BindAction("AttackSecondary", IE_Pressed, this, &AMainCharacter::AttackSecondaryButtonDown);
 	PlayerInputComponent->BindAction("AttackSecondary", IE_Released, this, &AMainCharacter::AttackSecondaryButtonUp);
 
+	PlayerInputComponent->BindAction("CycleTargetRight", IE_Pressed, this, &AMainCharacter::CycleTargetRight);
+	PlayerInputComponent->BindAction("CycleTargetRight", IE_Released, this, &AMainCharacter::CycleTargetUp);
+	PlayerInputComponent->BindAction("CycleTargetLeft", IE_Pressed, this, &AMainCharacter::CycleTargetLeft);
+	PlayerInputComponent->BindAction("CycleTargetLeft", IE_Released, this, &AMainCharacter::CycleTargetUp);
+
 	// Bind axes movements
 	PlayerInputComponent->BindAxis("MoveForward", this, &AMainCharacter::MoveForward);
 	PlayerInputComponent->BindAxis("MoveRight", this, &AMainCharacter::MoveRight);
@@ -382,14 +405,30 @@ void AMainCharacter::EKeyDown()
 			return;
 		}
 
-		if (ActiveOverlappingItem)
+		if (!CanActOn(EBufferedInput::Interact))
+		{
+			BufferInput(EBufferedInput::Interact);
+			return;
+		}
+		Interact();
+	}
+}
+
+
+void AMainCharacter::Interact()
+{
+	if (ActiveOverlappingItem)
+	{
+		AWeapon* Weapon = Cast<AWeapon>(ActiveOverlappingItem);
+		if (Weapon)
 		{
-			AWeapon* Weapon = Cast<AWeapon>(ActiveOverlappingItem);
-			if (Weapon)
+			// The swing belongs to the weapon about to be replaced
+			if (bAttacking)
 			{
-				Weapon->Equip(this);
-				SetActiveOverlappingItem(nullptr);
+				CancelAttack();
 			}
+			Weapon->Equip(this);
+			SetActiveOverlappingItem(nullptr);
 		}
 	}
 }
@@ -415,7 +454,14 @@ void AMainCharacter::AttackPrimaryButtonDown()
 
 	if (EquippedWeapon)
 	{
-		Attack();
+		if (CanActOn(EBufferedInput::AttackPrimary))
+		{
+			PerformAttack(true);
+		}
+		else
+		{
+			BufferInput(EBufferedInput::AttackPrimary);
+		}
 	}
 }
 
@@ -441,7 +487,14 @@ void AMainCharacter::AttackSecondaryButtonDown()
 
 	if (EquippedWeapon)
 	{
-		Attack();
+		if (CanActOn(EBufferedInput::AttackSecondary))
+		{
+			PerformAttack(false);
+		}
+		else
+		{
+			BufferInput(EBufferedInput::AttackSecondary);
+		}
 	}
 }
 
@@ -476,6 +529,11 @@ void AMainCharacter::DecrementHealth(float DamageAmount)
 
 float AMainCharacter::TakeDamage(float DamageAmount, struct FDamageEvent const &DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
 {
+	if (!Alive())
+	{
+		return 0.f;
+	}
+
 	if (Health - DamageAmount <= 0.f)
 	{
 		Health -= DamageAmount;
@@ -523,6 +581,9 @@ void AMainCharacter::Die()
 		AnimInstance->Montage_JumpToSection(FName("Death"));
 	}
 	SetMovementState(EMovementState::EMS_Dead);
+
+	InputBuffer.Reset();
+	CloseCancelWindow();
 }
 
 
@@ -615,38 +676,95 @@ void AMainCharacter::SetEquippedWeapon(AWeapon* WeaponToSet)
 
 void AMainCharacter::Attack()
 {
-	if (!bAttacking && Alive())
+	if (bAttackPrimaryButtonDown)
 	{
-		bAttacking = true;
-		SetInterpToEnemy(true);
+		PerformAttack(true);
+	}
+	else if (bAttackSecondaryButtonDown)
+	{
+		PerformAttack(false);
+	}
+}
+
 
-		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-		if (AnimInstance && CombatMontage)
+void AMainCharacter::PerformAttack(bool bPrimary)
+{
+	if (!Alive() || EquippedWeapon == nullptr || !CanActOn(bPrimary ? EBufferedInput::AttackPrimary : EBufferedInput::AttackSecondary))
+	{
+		return;
+	}
+
+	// Cutting the previous swing short, so its hit window must not stay open into this one
+	if (bAttacking)
+	{
+		EquippedWeapon->CloseHitWindow(EquippedWeapon->ActiveHitWindow);
+	}
+	CloseCancelWindow();
+
+	bAttacking = true;
+	SetInterpToEnemy(true);
+
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AnimInstance && CombatMontage)
+	{
+		FName Section("Attack_Secondary");
+		if (bPrimary)
 		{
-			if (bAttackPrimaryButtonDown)
-			{
-				int32 Selection = FMath::RandRange(0, 1);
-				switch (Selection)
-				{
-				case 0:
-					AnimInstance->Montage_Play(CombatMontage, 1.6f);
-					AnimInstance->Montage_JumpToSection(FName("Attack_Primary"), CombatMontage);
-					break;
-				case 1:
-					AnimInstance->Montage_Play(CombatMontage, 1.6f);
-					AnimInstance->Montage_JumpToSection(FName("Attack_Primary_Alt"), CombatMontage);
-					break;
-				default:
-					;
-				}
-			}
-			else if (bAttackSecondaryButtonDown)
-			{
-				AnimInstance->Montage_Play(CombatMontage, 1.6f);
-				AnimInstance->Montage_JumpToSection(FName("Attack_Secondary"), CombatMontage);
-			}
+			Section = FMath::RandRange(0, 1) == 0 ? FName("Attack_Primary") : FName("Attack_Primary_Alt");
+		}
+
+		const float PlayRate = 1.6f;
+		AnimInstance->Montage_Play(CombatMontage, PlayRate);
+		AnimInstance->Montage_JumpToSection(Section, CombatMontage);
+
+		// Montages that don't place their own windows still let the swing be chained before it ends
+		const int32 SectionIndex = CombatMontage->GetSectionIndex(Section);
+		if (DefaultCancelWindowStart > 0.f && SectionIndex != INDEX_NONE && !HasCancelWindowNotifies())
+		{
+			const float SectionTime = CombatMontage->GetSectionLength(SectionIndex) / (PlayRate * CombatMontage->RateScale);
+			GetWorldTimerManager().SetTimer(DefaultCancelWindowTimer, this, &AMainCharacter::OpenDefaultCancelWindow, FMath::Max(SectionTime * DefaultCancelWindowStart, KINDA_SMALL_NUMBER));
+		}
+	}
+}
+
+
+bool AMainCharacter::HasCancelWindowNotifies() const
+{
+	for (const FAnimNotifyEvent& Notify : CombatMontage->Notifies)
+	{
+		if (Cast<UAnimNotifyState_CancelWindow>(Notify.NotifyStateClass))
+		{
+			return true;
 		}
 	}
+	return false;
+}
+
+
+void AMainCharacter::OpenDefaultCancelWindow()
+{
+	if (bAttacking)
+	{
+		OpenCancelWindow(true, true, false);
+	}
+}
+
+
+void AMainCharacter::CancelAttack()
+{
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AnimInstance && CombatMontage)
+	{
+		AnimInstance->Montage_Stop(0.15f, CombatMontage);
+	}
+	if (EquippedWeapon)
+	{
+		EquippedWeapon->CloseHitWindow(EquippedWeapon->ActiveHitWindow);
+	}
+	CloseCancelWindow();
+
+	bAttacking = false;
+	SetInterpToEnemy(false);
 }
 
 
@@ -654,6 +772,12 @@ void AMainCharacter::AttackEnd()
 {
 	bAttacking = false;
 	SetInterpToEnemy(false);
+	CloseCancelWindow();
+
+	if (ConsumeBufferedInput())
+	{
+		return;
+	}
 	if (bAttackPrimaryButtonDown || bAttackSecondaryButtonDown)
 	{
 		Attack();
@@ -661,9 +785,117 @@ void AMainCharacter::AttackEnd()
 }
 
 
+void AMainCharacter::OpenCancelWindow(bool bAllowAttack, bool bAllowJump, bool bAllowInteract)
+{
+	bCancelWindowAttack = bAllowAttack;
+	bCancelWindowJump = bAllowJump;
+	bCancelWindowInteract = bAllowInteract;
+
+	// This is the earliest frame a press made earlier in the swing can act
+	if (bAttacking)
+	{
+		ConsumeBufferedInput();
+	}
+}
+
+
+void AMainCharacter::CloseCancelWindow()
+{
+	GetWorldTimerManager().ClearTimer(DefaultCancelWindowTimer);
+
+	bCancelWindowAttack = false;
+	bCancelWindowJump = false;
+	bCancelWindowInteract = false;
+}
+
+
+void AMainCharacter::BufferInput(EBufferedInput Input)
+{
+	FBufferedInput& Entry = InputBuffer.AddDefaulted_GetRef();
+	Entry.Input = Input;
+	Entry.Time = GetWorld()->GetTimeSeconds();
+
+	if (InputBuffer.Num() > MaxBufferedInputs)
+	{
+		InputBuffer.RemoveAt(0);
+	}
+}
+
+
+bool AMainCharacter::ConsumeBufferedInput()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Newest first, since the latest press is what the player wants now
+	int32 NumExpired = 0;
+	for (int32 Index = InputBuffer.Num() - 1; Index >= 0; --Index)
+	{
+		const FBufferedInput Entry = InputBuffer[Index];
+		if (Now - Entry.Time > InputBufferTime)
+		{
+			NumExpired = Index + 1;
+			break;
+		}
+		if (!CanActOn(Entry.Input))
+		{
+			continue;
+		}
+
+		InputBuffer.Reset();
+
+		INC_DWORD_STAT(STAT_BufferedInputsConsumed);
+		SET_FLOAT_STAT(STAT_BufferedInputDelay, (Now - Entry.Time) * 1000.f);
+
+		switch (Entry.Input)
+		{
+		case EBufferedInput::AttackPrimary:
+			PerformAttack(true);
+			break;
+		case EBufferedInput::AttackSecondary:
+			PerformAttack(false);
+			break;
+		case EBufferedInput::Jump:
+			Jump();
+			break;
+		case EBufferedInput::Interact:
+			Interact();
+			break;
+		default:
+			;
+		}
+		return true;
+	}
+
+	InputBuffer.RemoveAt(0, NumExpired);
+	return false;
+}
+
+
+bool AMainCharacter::CanActOn(EBufferedInput Input) const
+{
+	if (!bAttacking)
+	{
+		return true;
+	}
+
+	switch (Input)
+	{
+	case EBufferedInput::AttackPrimary:
+	case EBufferedInput::AttackSecondary:
+		return bCancelWindowAttack;
+	case EBufferedInput::Jump:
+		return bCancelWindowJump;
+	case EBufferedInput::Interact:
+		return bCancelWindowInteract;
+	default:
+		return false;
+	}
+}
+
+
 void AMainCharacter::PlaySwingSound()
 {
-	if (EquippedWeapon->SwingSound)
+	if (EquippedWeapon && EquippedWeapon->SwingSound)
 	{
 		UGameplayStatics::PlaySound2D(this, EquippedWeapon->SwingSound);
 	}
@@ -685,51 +917,47 @@ void AMainCharacter::Jump()
 
 	if (Alive())
 	{
+		// Mid-swing, the jump waits for a cancel window or the end of the attack
+		if (!CanActOn(EBufferedInput::Jump))
+		{
+			BufferInput(EBufferedInput::Jump);
+			return;
+		}
+		if (bAttacking)
+		{
+			CancelAttack();
+		}
 		ACharacter::Jump();
 	}
 }
 
 
-void AMainCharacter::UpdateCombatTarget()
+void AMainCharacter::CycleTargetRight()
 {
-	TArray<AActor*> OverlappingActors;
-	GetOverlappingActors(OverlappingActors, EnemyFilter);
-
-	if (OverlappingActors.Num() == 0)
+	CycleTargetPressTime = GetWorld()->GetTimeSeconds();
+	if (CombatTargetTracker && Alive())
 	{
-		if (MainPlayerController)
-		{
-			MainPlayerController->RemoveEnemyHealthBar();
-		}
-		return;
+		CombatTargetTracker->CycleTarget(1);
 	}
+}
+
 
-	AEnemy* ClosestEnemy = Cast<AEnemy>(OverlappingActors[0]);
-	if (ClosestEnemy)
+void AMainCharacter::CycleTargetLeft()
+{
+	CycleTargetPressTime = GetWorld()->GetTimeSeconds();
+	if (CombatTargetTracker && Alive())
 	{
-		FVector Location = GetActorLocation();
-		float MinDistance = (ClosestEnemy->GetActorLocation() - Location).Size();
+		CombatTargetTracker->CycleTarget(-1);
+	}
+}
 
-		for (auto Actor : OverlappingActors)
-		{
-			AEnemy* Enemy = Cast<AEnemy>(Actor);
-			if (Enemy)
-			{
-				float DistanceToActor = (Enemy->GetActorLocation() - Location).Size();
-				if (DistanceToActor < MinDistance)
-				{
-					MinDistance = DistanceToActor;
-					ClosestEnemy = Enemy;
-				}
-			}
-		}
 
-		if (MainPlayerController)
-		{
-			MainPlayerController->DisplayEnemyHealthBar();
-		}
-		SetCombatTarget(ClosestEnemy);
-		bHasCombatTarget = true;
+void AMainCharacter::CycleTargetUp()
+{
+	// A tap cycles; a long hold undoes the lock it started with and goes back to the closest enemy
+	if (CombatTargetTracker && GetWorld()->GetTimeSeconds() - CycleTargetPressTime >= ReleaseLockHoldTime)
+	{
+		CombatTargetTracker->ClearLock();
 	}
 }
 
@@ -5,6 +5,27 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "MainCharacter.h"
 
+void FMainCharacterAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: only copy what Update needs out of the pawn
+	const APawn* Pawn = InAnimInstance->TryGetPawnOwner();
+	const UPawnMovementComponent* Movement = Pawn ? Pawn->GetMovementComponent() : nullptr;
+	Velocity = Pawn ? Pawn->GetVelocity() : FVector::ZeroVector;
+	bIsFalling = Movement && Movement->IsFalling();
+}
+
+void FMainCharacterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	// Worker thread when the anim Blueprint uses multi-threaded update; runs before the graph reads the properties
+	UMainCharacterAnimInstance* AnimInstance = CastChecked<UMainCharacterAnimInstance>(GetAnimInstanceObject());
+	AnimInstance->MovementSpeed = FVector(Velocity.X, Velocity.Y, 0.f).Size();
+	AnimInstance->bIsInAir = bIsFalling;
+}
+
 void UMainCharacterAnimInstance::NativeInitializeAnimation()
 {
 	// Pawn will be nullptr the first time
@@ -20,22 +41,4 @@ void UMainCharacterAnimInstance::NativeInitializeAnimation()
 
 void UMainCharacterAnimInstance::UpdateAnimationProperties()
 {
-	if (Pawn == nullptr)
-	{
-		Pawn = TryGetPawnOwner();
-	}
-
-	if (Pawn)
-	{
-		FVector Speed = Pawn->GetVelocity();
-		FVector LateralSpeed = FVector(Speed.X, Speed.Y, 0.f);
-		MovementSpeed = LateralSpeed.Size();
-
-		bIsInAir = Pawn->GetMovementComponent()->IsFalling();
-
-		if (MainCharacter == nullptr)
-		{
-			MainCharacter = Cast<AMainCharacter>(Pawn);
-		}
-	}
-}
\ No newline at end of file
+}
@@ -45,8 +45,7 @@ void AMainPlayerController::Tick(float DeltaTime)
 
 	if (EnemyHealthBar)
 	{
-		FVector2D PositionInViewPort;
-		ProjectWorldLocationToScreen(EnemyLocation, PositionInViewPort);
+		FVector2D PositionInViewPort = EnemyScreenPosition;
 		PositionInViewPort.Y -= 100.f;
 
 		FVector2D SizeInViewPort(250.f, 25.f);
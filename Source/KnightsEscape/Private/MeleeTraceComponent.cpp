@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MeleeTraceComponent.h"
+#include "KnightsEscape.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Melee Trace"), STAT_MeleeTrace, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Melee Sweeps"), STAT_MeleeSweeps, STATGROUP_KnightsEscape);
+
+
+UMeleeTraceComponent::UMeleeTraceComponent()
+{
+	// Sweep after animation has placed the shape for this frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	NumSamples = 3;
+	MaxStepDistance = 30.f;
+	MaxSubsteps = 8;
+
+	TraceShape = nullptr;
+	bSwinging = false;
+}
+
+
+void UMeleeTraceComponent::SetTraceShape(UBoxComponent* Shape)
+{
+	TraceShape = Shape;
+}
+
+
+void UMeleeTraceComponent::BeginSwing()
+{
+	if (TraceShape == nullptr)
+	{
+		return;
+	}
+
+	HitActors.Reset();
+	LastTransform = TraceShape->GetComponentTransform();
+	bSwinging = true;
+	SetComponentTickEnabled(true);
+
+	// Catch anything already inside the shape as the window opens
+	Sweep(LastTransform, LastTransform);
+}
+
+
+void UMeleeTraceComponent::EndSwing()
+{
+	bSwinging = false;
+	HitActors.Reset();
+	SetComponentTickEnabled(false);
+}
+
+
+void UMeleeTraceComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!bSwinging || TraceShape == nullptr)
+	{
+		return;
+	}
+
+	const FTransform Transform = TraceShape->GetComponentTransform();
+	Sweep(LastTransform, Transform);
+	LastTransform = Transform;
+}
+
+
+void UMeleeTraceComponent::Sweep(const FTransform& From, const FTransform& To)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeleeTrace);
+
+	AActor* Owner = GetOwner();
+	UWorld* World = GetWorld();
+
+	// The longest box axis is the blade, the smaller of the other two the thickness to sweep
+	const FVector Extent = TraceShape->GetUnscaledBoxExtent();
+	const FVector ScaledExtent = TraceShape->GetScaledBoxExtent();
+	const int32 Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	const float Radius = FMath::Min(ScaledExtent[(Axis + 1) % 3], ScaledExtent[(Axis + 2) % 3]);
+
+	const int32 Samples = FMath::Max(NumSamples, 2);
+	TArray<FVector, TInlineAllocator<8>> LocalPoints;
+	TArray<FVector, TInlineAllocator<8>> Previous;
+	float MaxDistance = 0.f;
+	for (int32 Sample = 0; Sample < Samples; ++Sample)
+	{
+		FVector Local = FVector::ZeroVector;
+		Local[Axis] = FMath::Lerp(-Extent[Axis], Extent[Axis], (float)Sample / (Samples - 1));
+		LocalPoints.Add(Local);
+
+		const FVector Start = From.TransformPosition(Local);
+		Previous.Add(Start);
+		MaxDistance = FMath::Max(MaxDistance, FVector::Dist(Start, To.TransformPosition(Local)));
+	}
+
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt(MaxDistance / FMath::Max(MaxStepDistance, 1.f)), 1, FMath::Max(MaxSubsteps, 1));
+
+	// Ignore whoever is swinging: the owner and, for held weapons, the character carrying it
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(MeleeTrace), false, Owner);
+	if (Owner && Owner->GetAttachParentActor())
+	{
+		Params.AddIgnoredActor(Owner->GetAttachParentActor());
+	}
+	const FCollisionObjectQueryParams ObjectParams(ECollisionChannel::ECC_Pawn);
+	const FCollisionShape Sphere = FCollisionShape::MakeSphere(Radius);
+
+	TArray<FHitResult> Hits;
+	for (int32 Step = 1; Step <= NumSteps; ++Step)
+	{
+		FTransform Blended;
+		Blended.Blend(From, To, (float)Step / NumSteps);
+
+		for (int32 Sample = 0; Sample < Samples; ++Sample)
+		{
+			const FVector Next = Blended.TransformPosition(LocalPoints[Sample]);
+			World->SweepMultiByObjectType(Hits, Previous[Sample], Next, FQuat::Identity, ObjectParams, Sphere, Params);
+			Previous[Sample] = Next;
+			INC_DWORD_STAT(STAT_MeleeSweeps);
+
+			for (const FHitResult& Hit : Hits)
+			{
+				AActor* HitActor = Hit.GetActor();
+				if (HitActor == nullptr || HitActors.Contains(HitActor))
+				{
+					continue;
+				}
+
+				HitActors.Add(HitActor);
+				OnHit.Broadcast(Hit);
+
+				// A hit can end the swing (the owner dies, the window closes)
+				if (!bSwinging)
+				{
+					return;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnQueueSubsystem.h"
+#include "KnightsEscape.h"
+#include "SpawnVolume.h"
+#include "Enemy.h"
+#include "EnemyPoolSubsystem.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Queue Tick"), STAT_SpawnQueueTick, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Backlog"), STAT_SpawnQueueBacklog, STATGROUP_KnightsEscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawns Finished"), STAT_SpawnsFinished, STATGROUP_KnightsEscape);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Average Spawn Cost (ms)"), STAT_AverageSpawnCost, STATGROUP_KnightsEscape);
+
+static TAutoConsoleVariable<float> CVarSpawnQueueBudgetMs(
+	TEXT("ke.SpawnQueue.BudgetMs"),
+	2.f,
+	TEXT("Milliseconds per frame the spawn queue may spend spawning; at least one step runs every frame."));
+
+
+USpawnQueueSubsystem::USpawnQueueSubsystem()
+{
+	NextBatchId = 0;
+	Backlog = 0;
+	AverageSpawnCostMs = 0.f;
+	CurrentSpawnSeconds = 0.0;
+}
+
+
+void USpawnQueueSubsystem::Deinitialize()
+{
+	Batches.Empty();
+	Backlog = 0;
+
+	Super::Deinitialize();
+}
+
+
+int32 USpawnQueueSubsystem::QueueBatch(ASpawnVolume* Volume, const TArray<UClass*>& Classes, const TArray<FVector>& Locations)
+{
+	check(Classes.Num() == Locations.Num());
+
+	FSpawnBatch& Batch = *Batches.Add_GetRef(MakeUnique<FSpawnBatch>());
+	Batch.Volume = Volume;
+	Batch.BatchId = NextBatchId++;
+	Batch.Classes = Classes;
+	Batch.Locations = Locations;
+
+	Backlog += Classes.Num();
+	return Batch.BatchId;
+}
+
+
+void USpawnQueueSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpawnQueueTick);
+
+	const double BudgetSeconds = CVarSpawnQueueBudgetMs.GetValueOnGameThread() / 1000.0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	bool bFirstStep = true;
+	while (Batches.Num() > 0 && (bFirstStep || FPlatformTime::Seconds() - StartTime < BudgetSeconds))
+	{
+		bFirstStep = false;
+
+		// Batches are served in the order they were queued
+		FSpawnBatch& Batch = *Batches[0];
+		if (!Batch.Volume.IsValid())
+		{
+			if (Batch.PendingActor)
+			{
+				Batch.PendingActor->Destroy();
+			}
+			Backlog -= Batch.Classes.Num() - Batch.NextSpawn + (Batch.PendingActor ? 1 : 0);
+			Batches.RemoveAt(0);
+			continue;
+		}
+
+		if (StepBatch(Batch))
+		{
+			ASpawnVolume* Volume = Batch.Volume.Get();
+			const int32 BatchId = Batch.BatchId;
+			const TArray<AActor*> SpawnedActors = MoveTemp(Batch.SpawnedActors);
+			Batches.RemoveAt(0);
+
+			// Listeners may queue the next wave, so the batch is gone before they hear about it
+			Volume->OnSpawnBatchComplete.Broadcast(BatchId, SpawnedActors);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SpawnQueueBacklog, Backlog);
+	SET_FLOAT_STAT(STAT_AverageSpawnCost, AverageSpawnCostMs);
+}
+
+
+bool USpawnQueueSubsystem::StepBatch(FSpawnBatch& Batch)
+{
+	const double StepStart = FPlatformTime::Seconds();
+	bool bSpawnDone = false;
+
+	if (Batch.PendingActor)
+	{
+		AActor* Actor = Batch.PendingActor;
+		Batch.PendingActor = nullptr;
+
+		UGameplayStatics::FinishSpawningActor(Actor, Batch.PendingTransform);
+		FinishSpawn(Batch, Actor);
+		bSpawnDone = true;
+	}
+	else if (Batch.NextSpawn < Batch.Classes.Num())
+	{
+		UClass* SpawnClass = Batch.Classes[Batch.NextSpawn];
+		const FVector Location = Batch.Locations[Batch.NextSpawn];
+		++Batch.NextSpawn;
+		CurrentSpawnSeconds = 0.0;
+
+		// Pooled enemies are already constructed, so they go out in a single step
+		UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+		if (Pool && SpawnClass && SpawnClass->IsChildOf(AEnemy::StaticClass()) && Pool->GetNumPooledEnemies(SpawnClass) > 0)
+		{
+			AEnemy* Enemy = Pool->AcquireEnemy(SpawnClass, Location, FRotator(0.f));
+			if (Enemy)
+			{
+				Batch.SpawnedActors.Add(Enemy);
+			}
+			bSpawnDone = true;
+		}
+		else
+		{
+			const FTransform SpawnTransform(FRotator(0.f), Location);
+			AActor* Actor = SpawnClass ? GetWorld()->SpawnActorDeferred<AActor>(SpawnClass, SpawnTransform) : nullptr;
+			if (Actor)
+			{
+				Batch.PendingActor = Actor;
+				Batch.PendingTransform = SpawnTransform;
+			}
+			else
+			{
+				// Nothing to finish, it just leaves the backlog
+				--Backlog;
+			}
+		}
+	}
+
+	CurrentSpawnSeconds += FPlatformTime::Seconds() - StepStart;
+
+	if (bSpawnDone)
+	{
+		const float SpawnCostMs = (float)(CurrentSpawnSeconds * 1000.0);
+		AverageSpawnCostMs = AverageSpawnCostMs > 0.f ? FMath::Lerp(AverageSpawnCostMs, SpawnCostMs, 0.1f) : SpawnCostMs;
+
+		--Backlog;
+		INC_DWORD_STAT(STAT_SpawnsFinished);
+	}
+
+	return Batch.PendingActor == nullptr && Batch.NextSpawn >= Batch.Classes.Num();
+}
+
+
+void USpawnQueueSubsystem::FinishSpawn(FSpawnBatch& Batch, AActor* Actor)
+{
+	if (Actor->IsPendingKill())
+	{
+		return;
+	}
+
+	AEnemy* Enemy = Cast<AEnemy>(Actor);
+	if (Enemy)
+	{
+		Enemy->SpawnDefaultController();
+
+		AAIController* SpawnAIController = Cast<AAIController>(Enemy->GetController());
+		if (SpawnAIController)
+		{
+			Enemy->AIController = SpawnAIController;
+		}
+	}
+
+	Batch.SpawnedActors.Add(Actor);
+}
+
+
+bool USpawnQueueSubsystem::IsTickable() const
+{
+	return Batches.Num() > 0;
+}
+
+
+ETickableTickType USpawnQueueSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+
+TStatId USpawnQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USpawnQueueSubsystem, STATGROUP_Tickables);
+}
\ No newline at end of file
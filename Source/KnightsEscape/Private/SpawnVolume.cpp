@@ -8,6 +8,12 @@
 #include "Creature.h"
 #include "Enemy.h"
 #include "AIController.h"
+#include "EnemyPoolSubsystem.h"
+#include "SpawnQueueSubsystem.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
 
 // Sets default values
 ASpawnVolume::ASpawnVolume()
@@ -16,6 +22,13 @@ ASpawnVolume::ASpawnVolume()
 	PrimaryActorTick.bCanEverTick = true;
 
 	SpawningBox = CreateDefaultSubobject<UBoxComponent>(TEXT("SpawningBox"));
+
+	SpawnPointSpacing = 150.f;
+	MaxSpawnPoints = 64;
+
+	PoolPrewarmCount = 4;
+
+	bSpawnPointsDirty = false;
 }
 
 // Called when the game starts or when spawned
@@ -30,16 +43,53 @@ void ASpawnVolume::BeginPlay()
 		SpawnArray.Add(Actor_3);
 		SpawnArray.Add(Actor_4);
 	}
+
+	BuildSpawnPoints();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &ASpawnVolume::OnNavigationGenerationFinished);
+	}
+
+	UEnemyPoolSubsystem* Pool = GetWorld()->GetSubsystem<UEnemyPoolSubsystem>();
+	if (Pool && PoolPrewarmCount > 0)
+	{
+		TArray<UClass*> EnemyClasses;
+		for (const TSubclassOf<AActor>& SpawnClass : SpawnArray)
+		{
+			if (SpawnClass && SpawnClass->IsChildOf(AEnemy::StaticClass()))
+			{
+				EnemyClasses.AddUnique(SpawnClass);
+			}
+		}
+
+		for (UClass* EnemyClass : EnemyClasses)
+		{
+			Pool->Prewarm(EnemyClass, PoolPrewarmCount, SpawningBox->GetComponentLocation());
+		}
+	}
 }
 
 // Called every frame
 void ASpawnVolume::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	// Rebuilt here rather than in GetSpawnPoint, which is a pure node and must not change state
+	if (bSpawnPointsDirty)
+	{
+		BuildSpawnPoints();
+	}
 }
 
 FVector ASpawnVolume::GetSpawnPoint()
 {
+	if (SpawnPoints.Num() > 0)
+	{
+		return SpawnPoints[FMath::RandRange(0, SpawnPoints.Num() - 1)];
+	}
+
 	FVector Extent = SpawningBox->GetScaledBoxExtent();
 	FVector Origin = SpawningBox->GetComponentLocation();
 
@@ -55,7 +105,15 @@ void ASpawnVolume::SpawnActor_Implementation(UClass* ToSpawn, const FVector& Loc
 
 		if (World)
 		{
-			AActor* Actor = World->SpawnActor<AActor>(ToSpawn, Location, FRotator(0.f), SpawnParams);
+			// Enemies come out of the pool, which already gave them an AI controller
+			UEnemyPoolSubsystem* Pool = World->GetSubsystem<UEnemyPoolSubsystem>();
+			if (Pool && ToSpawn->IsChildOf(AEnemy::StaticClass()))
+			{
+				Pool->AcquireEnemy(ToSpawn, GetSpawnLocation(ToSpawn, Location), FRotator(0.f));
+				return;
+			}
+
+			AActor* Actor = World->SpawnActor<AActor>(ToSpawn, GetSpawnLocation(ToSpawn, Location), FRotator(0.f), SpawnParams);
 			
 			AEnemy* Enemy = Cast<AEnemy>(Actor);
 			if (Enemy)
@@ -73,6 +131,188 @@ void ASpawnVolume::SpawnActor_Implementation(UClass* ToSpawn, const FVector& Loc
 }
 
 
+/** Projects Candidate onto the navmesh and returns the point there, if a capsule of that size fits on top of it */
+static bool ProjectSpawnPoint(const UWorld* World, const ANavigationData* NavData, const FVector& Candidate, const FVector& QueryExtent, float CapsuleRadius, float CapsuleHalfHeight, const AActor* IgnoreActor, FVector& OutSpawnPoint)
+{
+	FNavLocation NavLocation;
+	if (!NavData->ProjectPoint(Candidate, NavLocation, QueryExtent))
+	{
+		return false;
+	}
+
+	const FVector CapsuleCenter = NavLocation.Location + FVector(0.f, 0.f, CapsuleHalfHeight + 2.f);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(SpawnPointClearance), false, IgnoreActor);
+	if (World->OverlapBlockingTestByChannel(CapsuleCenter, FQuat::Identity, ECollisionChannel::ECC_Pawn, FCollisionShape::MakeCapsule(CapsuleRadius, CapsuleHalfHeight), QueryParams))
+	{
+		return false;
+	}
+
+	OutSpawnPoint = NavLocation.Location;
+	return true;
+}
+
+
+FVector ASpawnVolume::GetSpawnLocation(UClass* SpawnClass, const FVector& SpawnPoint) const
+{
+	const ACharacter* Character = SpawnClass ? Cast<ACharacter>(SpawnClass->GetDefaultObject()) : nullptr;
+	if (Character)
+	{
+		return SpawnPoint + FVector(0.f, 0.f, Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() + 2.f);
+	}
+
+	return SpawnPoint;
+}
+
+
+void ASpawnVolume::BuildSpawnPoints()
+{
+	bSpawnPointsDirty = false;
+	SpawnPoints.Reset();
+
+	UWorld* World = GetWorld();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (NavData == nullptr || MaxSpawnPoints <= 0)
+	{
+		return;
+	}
+
+	// Leave room for the largest character this volume spawns
+	float CapsuleRadius = 34.f;
+	float CapsuleHalfHeight = 88.f;
+	for (const TSubclassOf<AActor>& SpawnClass : SpawnArray)
+	{
+		const ACharacter* Character = SpawnClass ? Cast<ACharacter>(SpawnClass->GetDefaultObject()) : nullptr;
+		if (Character)
+		{
+			CapsuleRadius = FMath::Max(CapsuleRadius, Character->GetCapsuleComponent()->GetScaledCapsuleRadius());
+			CapsuleHalfHeight = FMath::Max(CapsuleHalfHeight, Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+		}
+	}
+
+	const FVector Origin = SpawningBox->GetComponentLocation();
+	const FVector Extent = SpawningBox->GetScaledBoxExtent();
+	const float Spacing = FMath::Max(SpawnPointSpacing, 10.f);
+	const FVector QueryExtent(Spacing * 0.5f, Spacing * 0.5f, Extent.Z);
+
+	// Background grid for the Poisson-disk neighbour test, sized so a cell holds at most one point
+	const float GridCellSize = Spacing / FMath::Sqrt(2.f);
+	const int32 GridWidth = FMath::Max(FMath::CeilToInt(2.f * Extent.X / GridCellSize), 1);
+	const int32 GridHeight = FMath::Max(FMath::CeilToInt(2.f * Extent.Y / GridCellSize), 1);
+	TArray<int32> Grid;
+	Grid.Init(INDEX_NONE, GridWidth * GridHeight);
+
+	auto IsInsideBox = [&Origin, &Extent](const FVector& Point)
+	{
+		return FMath::Abs(Point.X - Origin.X) <= Extent.X && FMath::Abs(Point.Y - Origin.Y) <= Extent.Y;
+	};
+
+	auto GetGridCell = [&](const FVector& Point)
+	{
+		const int32 X = FMath::Clamp(FMath::FloorToInt((Point.X - Origin.X + Extent.X) / GridCellSize), 0, GridWidth - 1);
+		const int32 Y = FMath::Clamp(FMath::FloorToInt((Point.Y - Origin.Y + Extent.Y) / GridCellSize), 0, GridHeight - 1);
+		return FIntPoint(X, Y);
+	};
+
+	auto IsFarEnough = [&](const FVector& Point)
+	{
+		const FIntPoint Cell = GetGridCell(Point);
+		for (int32 Y = FMath::Max(Cell.Y - 2, 0); Y <= FMath::Min(Cell.Y + 2, GridHeight - 1); ++Y)
+		{
+			for (int32 X = FMath::Max(Cell.X - 2, 0); X <= FMath::Min(Cell.X + 2, GridWidth - 1); ++X)
+			{
+				const int32 Neighbour = Grid[Y * GridWidth + X];
+				if (Neighbour != INDEX_NONE && FVector::DistSquaredXY(SpawnPoints[Neighbour], Point) < FMath::Square(Spacing))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	};
+
+	TArray<int32> Active;
+	auto AddPoint = [&](const FVector& Point)
+	{
+		const FIntPoint Cell = GetGridCell(Point);
+		Grid[Cell.Y * GridWidth + Cell.X] = SpawnPoints.Num();
+		Active.Add(SpawnPoints.Num());
+		SpawnPoints.Add(Point);
+	};
+
+	// Bridson's algorithm, with every accepted point projected onto the navmesh and checked for clearance
+	const int32 MaxTries = 30;
+	for (int32 Try = 0; Try < MaxTries && SpawnPoints.Num() == 0; ++Try)
+	{
+		FVector SpawnPoint;
+		const FVector Candidate = UKismetMathLibrary::RandomPointInBoundingBox(Origin, Extent);
+		if (ProjectSpawnPoint(World, NavData, Candidate, QueryExtent, CapsuleRadius, CapsuleHalfHeight, this, SpawnPoint) && IsInsideBox(SpawnPoint))
+		{
+			AddPoint(SpawnPoint);
+		}
+	}
+
+	while (Active.Num() > 0 && SpawnPoints.Num() < MaxSpawnPoints)
+	{
+		const int32 ActiveIndex = FMath::RandRange(0, Active.Num() - 1);
+		const FVector Center = SpawnPoints[Active[ActiveIndex]];
+
+		bool bAccepted = false;
+		for (int32 Try = 0; Try < MaxTries && !bAccepted; ++Try)
+		{
+			const float Angle = FMath::FRandRange(0.f, 2.f * PI);
+			const float Radius = FMath::FRandRange(Spacing, 2.f * Spacing);
+			const FVector Candidate = Center + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f);
+
+			FVector SpawnPoint;
+			if (IsInsideBox(Candidate)
+				&& ProjectSpawnPoint(World, NavData, Candidate, QueryExtent, CapsuleRadius, CapsuleHalfHeight, this, SpawnPoint)
+				&& IsInsideBox(SpawnPoint)
+				&& IsFarEnough(SpawnPoint))
+			{
+				AddPoint(SpawnPoint);
+				bAccepted = true;
+			}
+		}
+
+		if (!bAccepted)
+		{
+			Active.RemoveAtSwap(ActiveIndex);
+		}
+	}
+
+	SpawnPoints.Shrink();
+}
+
+
+void ASpawnVolume::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	// Rebuilt on the next tick, after the navmesh has settled
+	bSpawnPointsDirty = true;
+}
+
+
+int32 ASpawnVolume::QueueSpawnBatch(TSubclassOf<AActor> ToSpawn, int32 Count)
+{
+	USpawnQueueSubsystem* SpawnQueue = GetWorld()->GetSubsystem<USpawnQueueSubsystem>();
+	if (SpawnQueue == nullptr || Count <= 0)
+	{
+		return INDEX_NONE;
+	}
+
+	TArray<UClass*> Classes;
+	TArray<FVector> Locations;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		UClass* SpawnClass = ToSpawn ? ToSpawn : GetSpawnActor();
+		Classes.Add(SpawnClass);
+		Locations.Add(GetSpawnLocation(SpawnClass, GetSpawnPoint()));
+	}
+
+	return SpawnQueue->QueueBatch(this, Classes, Locations);
+}
+
+
 TSubclassOf<AActor> ASpawnVolume::GetSpawnActor()
 {
 	if (SpawnArray.Num() > 0)
@@ -10,6 +10,9 @@
 #include "Particles/ParticleSystemComponent.h"
 #include "Components/BoxComponent.h"
 #include "Enemy.h"
+#include "EnemyArchetype.h"
+#include "MeleeTraceComponent.h"
+#include "DamageQueueSubsystem.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "MainPlayerController.h"
 
@@ -22,11 +25,16 @@ AWeapon::AWeapon()
 	CombatCollision = CreateDefaultSubobject<UBoxComponent>(TEXT("CombatCollision"));
 	CombatCollision->SetupAttachment(GetRootComponent());
 
+	MeleeTrace = CreateDefaultSubobject<UMeleeTraceComponent>(TEXT("MeleeTrace"));
+
 	bWeaponParticle = false;
 
 	WeaponState = EWeaponState::EWS_Pickup;
 
 	Damage = 15.f;
+
+	ActiveHitWindow = INDEX_NONE;
+	HitDamageScale = 1.f;
 }
 
 
@@ -34,13 +42,12 @@ void AWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
-	CombatCollision->OnComponentBeginOverlap.AddDynamic(this, &AWeapon::CombatOnOverlapBegin);
-	CombatCollision->OnComponentEndOverlap.AddDynamic(this, &AWeapon::CombatOnOverlapEnd);
-
+	// Hits come from sweeping the box, so it never needs physics state of its own
 	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	CombatCollision->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
-	CombatCollision->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CombatCollision->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+	CombatCollision->SetGenerateOverlapEvents(false);
+
+	MeleeTrace->SetTraceShape(CombatCollision);
+	MeleeTrace->OnHit.AddUObject(this, &AWeapon::OnMeleeHit);
 }
 
 
@@ -108,50 +115,70 @@ void AWeapon::Equip(AMainCharacter* Character)
 }
 
 
-void AWeapon::CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult)
+void AWeapon::OnMeleeHit(const FHitResult& Hit)
 {
-	if (OtherActor)
+	AEnemy* Enemy = Cast<AEnemy>(Hit.GetActor());
+	if (Enemy)
 	{
-		AEnemy* Enemy = Cast<AEnemy>(OtherActor);
-		if (Enemy)
+		UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+		if (DamageQueue == nullptr)
+		{
+			return;
+		}
+
+		const UEnemyArchetype* Archetype = Enemy->GetEnemyArchetype();
+
+		FQueuedHit QueuedHit;
+		QueuedHit.Target = Enemy;
+		QueuedHit.Causer = this;
+		QueuedHit.Instigator = WeaponInstigator;
+		if (DamageTypeClass)
+		{
+			QueuedHit.Damage = Damage * HitDamageScale;
+			QueuedHit.DamageTypeClass = DamageTypeClass;
+		}
+
+		const USkeletalMeshSocket* WeaponSocket = SkeletalMesh->GetSocketByName("WeaponSocket");
+		if (WeaponSocket)
 		{
-			if (Enemy->HitParticles)
-			{
-				const USkeletalMeshSocket* WeaponSocket = SkeletalMesh->GetSocketByName("WeaponSocket");
-				if (WeaponSocket)
-				{
-					FVector SocketLocation = WeaponSocket->GetSocketLocation(SkeletalMesh);
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticles, SocketLocation, FRotator(0.f), false);
-				}
-			}
-
-			if (Enemy->HitSound)
-			{
-				UGameplayStatics::PlaySound2D(this, Enemy->HitSound);
-			}
-
-			if (DamageTypeClass)
-			{
-				UGameplayStatics::ApplyDamage(Enemy, Damage, WeaponInstigator, this, DamageTypeClass);
-			}
+			QueuedHit.Particles = Archetype->HitParticles;
+			QueuedHit.Location = WeaponSocket->GetSocketLocation(SkeletalMesh);
 		}
+		QueuedHit.Sound = Archetype->HitSound;
+
+		DamageQueue->QueueHit(QueuedHit);
 	}
 }
 
 
-void AWeapon::CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AWeapon::ActivateCollision()
 {
+	MeleeTrace->BeginSwing();
+}
 
+
+void AWeapon::DeactivateCollision()
+{
+	MeleeTrace->EndSwing();
 }
 
 
-void AWeapon::ActivateCollision()
+void AWeapon::OpenHitWindow(int32 WindowId, float DamageScale)
 {
-	CombatCollision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	ActiveHitWindow = WindowId;
+	HitDamageScale = DamageScale;
+	ActivateCollision();
 }
 
 
-void AWeapon::DeactivateCollision()
+void AWeapon::CloseHitWindow(int32 WindowId)
 {
-	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	if (ActiveHitWindow != WindowId)
+	{
+		return;
+	}
+
+	ActiveHitWindow = INDEX_NONE;
+	HitDamageScale = 1.f;
+	DeactivateCollision();
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AnimBudgetSubsystem.generated.h"
+
+/** A budgeted mesh and how much it matters this frame */
+struct FAnimBudgetEntry
+{
+	class UBudgetedSkeletalMeshComponent* Component;
+	float Significance;
+
+	/** Fights need every frame of their montages and hit windows */
+	bool bAlwaysFullRate;
+	bool bRendered;
+};
+
+/**
+ * Keeps the game thread cost of budgeted skeletal meshes under ke.AnimBudget.BudgetMs. Every frame
+ * the meshes are ranked by distance to the player and combat state, the most significant update
+ * every frame while their measured cost fits the budget, and the rest update every few frames or,
+ * when they are not on screen, not at all.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UAnimBudgetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UAnimBudgetSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void RegisterComponent(UBudgetedSkeletalMeshComponent* Component);
+	void UnregisterComponent(UBudgetedSkeletalMeshComponent* Component);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	void GatherEntries(const FVector& PlayerLocation);
+
+	TArray<UBudgetedSkeletalMeshComponent*> Components;
+
+	/** Handed to each registered mesh in turn, so throttled meshes spread over the frames of their period */
+	uint32 NextUpdatePhase;
+
+	/** Rebuilt every tick, kept to reuse its allocation */
+	TArray<FAnimBudgetEntry> Entries;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "AnimNotifyState_CancelWindow.generated.h"
+
+/**
+ * Part of the main character's attack that the allowed inputs may cut short. Presses buffered
+ * earlier in the swing act as soon as the window opens.
+ */
+UCLASS(meta = (DisplayName = "Cancel Window"))
+class KNIGHTSESCAPE_API UAnimNotifyState_CancelWindow : public UAnimNotifyState
+{
+	GENERATED_BODY()
+
+public:
+
+	UAnimNotifyState_CancelWindow();
+
+	/** Chain into the next swing */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	bool bAllowAttack;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	bool bAllowJump;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	bool bAllowInteract;
+
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+
+	virtual FString GetNotifyName_Implementation() const override;
+};
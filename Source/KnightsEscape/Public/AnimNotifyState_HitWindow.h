@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "AnimNotifyState_HitWindow.generated.h"
+
+/**
+ * Keeps the owner's melee collision live for the length of the notify. Works on enemies (their bite
+ * collision) and on the main character (the equipped weapon).
+ */
+UCLASS(meta = (DisplayName = "Hit Window"))
+class KNIGHTSESCAPE_API UAnimNotifyState_HitWindow : public UAnimNotifyState
+{
+	GENERATED_BODY()
+
+public:
+
+	UAnimNotifyState_HitWindow();
+
+	/** Tells overlapping windows in one montage apart; a window only closes the collision it opened */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	int32 WindowId;
+
+	/** Multiplier on the attacker's damage for hits landed inside this window */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	float DamageScale;
+
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+
+	virtual FString GetNotifyName_Implementation() const override;
+};
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "AnimNotify_AttackEnd.generated.h"
+
+/** Ends the owner's current attack, for enemies and the main character */
+UCLASS(meta = (DisplayName = "Attack End"))
+class KNIGHTSESCAPE_API UAnimNotify_AttackEnd : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+
+	virtual FString GetNotifyName_Implementation() const override;
+};
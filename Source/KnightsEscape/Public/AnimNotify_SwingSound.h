@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "AnimNotify_SwingSound.generated.h"
+
+/** Plays a swing sound for the owner's attack */
+UCLASS(meta = (DisplayName = "Swing Sound"))
+class KNIGHTSESCAPE_API UAnimNotify_SwingSound : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Played instead of the main character's weapon swing sound when set; enemies only play this */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Sound")
+	class USoundBase* Sound;
+
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+
+	virtual FString GetNotifyName_Implementation() const override;
+};
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "BudgetedSkeletalMeshComponent.generated.h"
+
+/**
+ * Skeletal mesh whose update rate is handed out by UAnimBudgetSubsystem. It times its own ticks so
+ * the allocator knows what a full update costs, and skips frames when it is told to tick less often,
+ * catching up with the accumulated delta time on the next frame it does tick.
+ */
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class KNIGHTSESCAPE_API UBudgetedSkeletalMeshComponent : public USkeletalMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UBudgetedSkeletalMeshComponent(const FObjectInitializer& ObjectInitializer);
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Updates once every Period frames; a period of 0 stops updates until it is raised again */
+	void SetUpdatePeriod(int32 Period);
+
+	/** Offset into the period, fixed when the mesh is registered so it keeps its slot as the period changes */
+	FORCEINLINE void SetUpdatePhase(uint32 Phase) { UpdatePhase = Phase; }
+
+	FORCEINLINE int32 GetUpdatePeriod() const { return UpdatePeriod; }
+
+	/** Smoothed game thread cost of a full update, or a negative value before the first one has been measured */
+	FORCEINLINE float GetAverageTickTimeMs() const { return AverageTickTimeMs; }
+
+private:
+
+	int32 UpdatePeriod;
+	uint32 UpdatePhase;
+
+	/** Frames since the last update; caps the wait at one period whatever the phase */
+	int32 FramesSinceUpdate;
+
+	/** Delta time of the frames skipped since the last update */
+	float SkippedDeltaTime;
+
+	float AverageTickTimeMs;
+};
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CombatDirectorSubsystem.generated.h"
+
+/** An enemy holding one of a target's attack tokens */
+struct FAttackTokenHolder
+{
+	class AEnemy* Enemy;
+	float GrantTime;
+};
+
+/** Attack tokens handed out against one target, plus the enemies waiting for one in arrival order */
+struct FAttackTokenPool
+{
+	TWeakObjectPtr<AActor> Target;
+	TArray<FAttackTokenHolder> Holders;
+	TArray<AEnemy*> Waiting;
+};
+
+/**
+ * Bounds how many enemies can swing at the same target at once. Enemies ask for a token when their
+ * attack timer fires, wait in a FIFO queue while the target's tokens are taken, and granted attacks
+ * are spread out so only a few start in any one frame.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UCombatDirectorSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UCombatDirectorSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Queues Enemy for an attack token against Target; Enemy->Attack() is called once one is granted */
+	void RequestAttack(AEnemy* Enemy, AActor* Target);
+
+	/** Returns Enemy's token, if it holds one */
+	void ReleaseAttack(AEnemy* Enemy);
+
+	/** Drops Enemy from every queue without touching a token it already holds */
+	void CancelAttackRequest(AEnemy* Enemy);
+
+	/** Drops Enemy from every queue and returns its token */
+	void RemoveEnemy(AEnemy* Enemy);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	/** Hands free tokens to waiting enemies while this frame's attack start budget lasts */
+	void GrantTokens(FAttackTokenPool& Pool);
+
+	/** Attack starts left this frame */
+	int32 GetStartBudget();
+
+	TArray<FAttackTokenPool> Pools;
+
+	uint64 StartFrame;
+	int32 StartsThisFrame;
+};
\ No newline at end of file
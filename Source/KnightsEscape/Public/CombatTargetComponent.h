@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CombatTargetComponent.generated.h"
+
+/** Candidate on screen this frame */
+struct FLockOnCandidate
+{
+	TWeakObjectPtr<class AEnemy> Enemy;
+
+	/** Degrees left (negative) or right of the view direction */
+	float ScreenAngle;
+
+	FVector2D ScreenPosition;
+};
+
+/**
+ * Picks the player's combat target from the enemies whose aggro range it is in. The candidates are
+ * kept up to date from the registry's range events instead of being gathered on every change, and a
+ * new or approaching enemy is only compared against the current target. Only candidates that have the
+ * player in their combat range are picked on their own, as before. The full set is re-ranked, by
+ * squared distance, only when the current target is lost, and the result is handed to the player at
+ * most once per frame.
+ *
+ * While there are candidates, the ones on screen are also sorted left to right once per frame. Lock-on
+ * cycling steps through that array from the current target, and the enemy health bar is placed from it.
+ */
+UCLASS(ClassGroup = (Combat), meta = (BlueprintSpawnableComponent))
+class KNIGHTSESCAPE_API UCombatTargetComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UCombatTargetComponent();
+
+	/** Adds Enemy as a candidate, and ranks it against the current target once it is in combat range */
+	void AddCandidate(AEnemy* Enemy);
+
+	void RemoveCandidate(AEnemy* Enemy);
+
+	/** Re-ranks every candidate next frame, for when the current target may no longer be the closest */
+	void Invalidate();
+
+	/** Locks on to the next enemy on screen to the right (Direction > 0) or left of the current target */
+	void CycleTarget(int32 Direction);
+
+	/** Goes back to targeting the closest candidate */
+	void ClearLock();
+
+	/** The locked target while there is one, otherwise the closest candidate in combat range */
+	AEnemy* GetCurrentTarget() const;
+
+	FORCEINLINE AEnemy* GetBestCandidate() const { return BestCandidate.Get(); }
+
+	FORCEINLINE const TArray<TWeakObjectPtr<AEnemy>>& GetCandidates() const { return Candidates; }
+
+	FORCEINLINE const TArray<FLockOnCandidate>& GetScreenCandidates() const { return ScreenCandidates; }
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+
+	/** Finds the closest candidate in combat range, dropping any that have been destroyed */
+	void Rerank();
+
+	/** Enemy has the owning player in its combat range, so it may become the target without a lock */
+	bool IsInCombatRange(const AEnemy* Enemy) const;
+
+	/** Hands the current target to the owning player */
+	void ApplyTarget();
+
+	/** Rebuilds ScreenCandidates from the player's view */
+	void UpdateScreenCandidates();
+
+	/** Shows the enemy health bar over the current target while it is on screen */
+	void UpdateHealthBar();
+
+	TArray<TWeakObjectPtr<AEnemy>> Candidates;
+
+	TWeakObjectPtr<AEnemy> BestCandidate;
+
+	/** Chosen by cycling; overrides BestCandidate until it stops being a candidate */
+	TWeakObjectPtr<AEnemy> LockedTarget;
+
+	bool bNeedsRerank;
+
+	/** On-screen candidates, sorted by ScreenAngle */
+	TArray<FLockOnCandidate> ScreenCandidates;
+
+	/** The current target's entry in ScreenCandidates, INDEX_NONE while it is off screen */
+	int32 ScreenTargetIndex;
+
+	/** First entry in ScreenCandidates right of the view direction */
+	int32 ScreenCenterIndex;
+};
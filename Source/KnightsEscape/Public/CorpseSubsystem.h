@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CorpseSubsystem.generated.h"
+
+/**
+ * Leaves dead characters behind as posed meshes with no actor, controller, movement or timers of
+ * their own. Each corpse is a poseable mesh holding a copy of the final pose, owned by one holder
+ * actor. Past ke.Corpse.MaxCorpses the oldest corpse is reused for the newest.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UCorpseSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UCorpseSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Copies Mesh's current pose, materials and transform into a corpse; false if corpses are disabled */
+	bool AddCorpse(class USkeletalMeshComponent* Mesh);
+
+	FORCEINLINE int32 GetNumCorpses() const { return Corpses.Num(); }
+
+private:
+
+	class UPoseableMeshComponent* MakeCorpseComponent();
+
+	/** Owns the corpse components, spawned with the first corpse */
+	UPROPERTY()
+	AActor* CorpseHolder;
+
+	/** Oldest first */
+	UPROPERTY()
+	TArray<UPoseableMeshComponent*> Corpses;
+};
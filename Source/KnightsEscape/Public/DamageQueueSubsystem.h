@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "DamageQueueSubsystem.generated.h"
+
+/** One hit waiting to be resolved: damage to apply and the feedback to show for it */
+struct FQueuedHit
+{
+	FQueuedHit()
+		: Damage(0.f)
+		, Particles(nullptr)
+		, Location(FVector::ZeroVector)
+		, Sound(nullptr)
+		, bDestroyCauser(false)
+	{}
+
+	TWeakObjectPtr<AActor> Target;
+	TWeakObjectPtr<AActor> Causer;
+	TWeakObjectPtr<AController> Instigator;
+
+	/** Nothing is applied for a hit with no damage, only its feedback shown */
+	float Damage;
+	TSubclassOf<UDamageType> DamageTypeClass;
+
+	/** Spawned at Location, at most once per target per frame */
+	class UParticleSystem* Particles;
+	FVector Location;
+
+	/** Played at most once per target per frame */
+	class USoundBase* Sound;
+
+	/** Destroys Causer once the hit is resolved, for one-shot sources that must still be the causer when it lands */
+	bool bDestroyCauser;
+};
+
+/** Runs UDamageQueueSubsystem's resolve pass in its tick group */
+USTRUCT()
+struct FDamageQueueTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	FDamageQueueTickFunction()
+		: Target(nullptr)
+	{}
+
+	class UDamageQueueSubsystem* Target;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FDamageQueueTickFunction> : public TStructOpsTypeTraitsBase2<FDamageQueueTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Collects melee and explosive hits during the frame and resolves them in one pass at the end of
+ * it. Hits on the same target from the same source are summed into one damage event, hit particles
+ * and sounds play once per target, and targets that are already dead take no further damage.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UDamageQueueSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UDamageQueueSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void QueueHit(const FQueuedHit& Hit);
+
+	/** Applies everything queued so far */
+	void ResolveHits();
+
+	FORCEINLINE int32 GetNumQueuedHits() const { return PendingHits.Num(); }
+
+private:
+
+	TArray<FQueuedHit> PendingHits;
+
+	/** Hits being resolved; hits queued while resolving wait for the next pass */
+	TArray<FQueuedHit> ResolvingHits;
+
+	FDamageQueueTickFunction TickFunction;
+};
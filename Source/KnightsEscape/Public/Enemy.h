@@ -18,6 +18,17 @@ enum class EEnemyMovementState : uint8
 	EMS_MAX				UMETA(DisplayName = "DefaultMAX")
 };
 
+/** Update-rate tier assigned by UEnemySignificanceSubsystem, most significant first */
+UENUM(BlueprintType)
+enum class EEnemySignificance : uint8
+{
+	ESI_High			UMETA(DisplayName = "High"),
+	ESI_Medium			UMETA(DisplayName = "Medium"),
+	ESI_Low				UMETA(DisplayName = "Low"),
+
+	ESI_MAX				UMETA(DisplayName = "DefaultMAX")
+};
+
 UCLASS()
 class KNIGHTSESCAPE_API AEnemy : public ACharacter
 {
@@ -25,7 +36,7 @@ class KNIGHTSESCAPE_API AEnemy : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	AEnemy();
+	AEnemy(const FObjectInitializer& ObjectInitializer);
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
 	EEnemyMovementState EnemyMovementState;
@@ -34,106 +45,172 @@ public:
 	FORCEINLINE EEnemyMovementState GetEnemyMovementStatus() { return EnemyMovementState; }
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
-	class USphereComponent* AggroSphere;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
-	USphereComponent* CombatSphere;
+	EEnemySignificance Significance;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
 	class AAIController* AIController;
 
+	/** Shared tuning for this enemy type; the class defaults of UEnemyArchetype are used when unset */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "AI")
+	class UEnemyArchetype* EnemyArchetype;
+
+	const UEnemyArchetype* GetEnemyArchetype() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float Health;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetMaxHealth() const;
+
+	/**
+	 * Tuning from before enemy archetypes, still set on existing enemy Blueprints. When a class has no
+	 * EnemyArchetype it is migrated once from the class defaults by UEnemyArchetypeSubsystem, so only the
+	 * class defaults are ever read. MaxHealth mirrors the archetype's for graphs and the health bar.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
 	float MaxHealth;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
 	float Damage;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
 	class UParticleSystem* HitParticles;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
 	class USoundCue* HitSound;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "AI")
 	USoundCue* BiteSound;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Combat")
-	class UBoxComponent* CombatCollision;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	class UAnimMontage* CombatMontage;
 
-	FTimerHandle AttackTimer;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Animation")
+	class UAnimationSharingSetup* AnimationSharingSetup;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	float AttackMinTime;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	float AttackMaxTime;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	TSubclassOf<UDamageType> DamageTypeClass;
 
-	FTimerHandle DeathTimer;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
 	float DeathDelay;
 
+	/** Legacy aggro / combat radii, copied from the editor-only spheres whenever the Blueprint is saved or cooked */
+	UPROPERTY()
+	float LegacyAggroRadius;
+
+	UPROPERTY()
+	float LegacyCombatRadius;
+
+	float GetLegacyAggroRadius() const;
+	float GetLegacyCombatRadius() const;
+
+#if WITH_EDITORONLY_DATA
+	/** Only there so existing Blueprints keep loading the radii set on them; never in cooked builds */
+	UPROPERTY()
+	class USphereComponent* AggroSphere;
+
+	UPROPERTY()
+	USphereComponent* CombatSphere;
+#endif
+
+	/** Shape of the bite, swept by MeleeTrace; it never has collision of its own */
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Combat")
+	class UBoxComponent* CombatCollision;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
+	class UMeleeTraceComponent* MeleeTrace;
+
+	/** World time after which the decision pass may ask for the next attack */
+	float NextAttackTime;
+
+	/** Waiting on UCombatDirectorSubsystem for an attack token */
+	bool bAttackRequested;
+
+	FTimerHandle DeathTimer;
+
 	UFUNCTION(BlueprintCallable)
 	void MoveToTarget(class AMainCharacter* Target);
 
+	/** Asks the AI controller for a path to Target, used when the shared flow field can't steer this enemy */
+	void RequestMoveTo(AMainCharacter* Target);
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "AI")
 	bool bOverlappingCombatSphere;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "AI")
 	AMainCharacter* CombatTarget;
 
+	/** Player whose aggro range this enemy is in, chased once it can be seen */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
+	AMainCharacter* AggroTarget;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void PostInitializeComponents() override;
 
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+#endif
+
+public:	
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
-	UFUNCTION()
-		virtual void AggroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult);
-	UFUNCTION()
-		virtual void AggroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Range events, driven by UEnemyRegistrySubsystem using the archetype's aggro / combat radii */
+	virtual void AggroRangeBegin(AMainCharacter* Main);
+	virtual void AggroRangeEnd(AMainCharacter* Main);
 
-	UFUNCTION()
-		virtual void CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult);
-	UFUNCTION()
-		virtual void CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	virtual void CombatRangeBegin(AMainCharacter* Main);
+	virtual void CombatRangeEnd(AMainCharacter* Main);
 
 
 
-	UFUNCTION()
-	void CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult);
-	UFUNCTION()
-	void CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	/** Bite landed on something during the current swing */
+	void OnMeleeHit(const FHitResult& Hit);
 
+	/** Starts sweeping the bite for hits */
 	UFUNCTION(BlueprintCallable)
 	void ActivateCollisions();
 
 	UFUNCTION(BlueprintCallable)
 	void DeactivateCollisions();
 
+	/** Hit window opened by UAnimNotifyState_HitWindow, INDEX_NONE while none is open */
+	int32 ActiveHitWindow;
+
+	/** Multiplier on Damage for bites landed in the open hit window */
+	float HitDamageScale;
+
+	void OpenHitWindow(int32 WindowId, float DamageScale);
+
+	/** Closes the bite collision if WindowId is the window that opened it */
+	void CloseHitWindow(int32 WindowId);
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
 	bool bAttacking;
 
 	UFUNCTION(BlueprintCallable)
 	void Attack();
 
+	/** Asks UCombatDirectorSubsystem for an attack token against CombatTarget; it calls Attack() once granted */
+	void RequestAttack();
+
 	UFUNCTION(BlueprintCallable)
 	void AttackEnd();
 
+	/** Stops chasing or fighting, for a target that is no longer valid */
+	void GiveUpTarget();
+
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const &DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
 
 	void Die(AActor* DeathCauser);
@@ -144,5 +221,31 @@ public:
 	bool Alive();
 	bool bHasValidTarget;
 
+	/** Returns the enemy to UEnemyPoolSubsystem when there is room, otherwise destroys it */
 	void Disappear();
+
+	/** Inactive and waiting in UEnemyPoolSubsystem */
+	bool bInPool;
+
+	/** Hides and deactivates the enemy and drops it from the AI subsystems, for UEnemyPoolSubsystem */
+	void ReturnToPool();
+
+	/** Resets the enemy to full health at Location and brings it back into play */
+	void LeavePool(const FVector& Location, const FRotator& Rotation);
+
+private:
+
+	/** No archetype asset on the class, so tuning comes from the legacy properties */
+	bool UsesLegacyTuning() const;
+
+	/** Random wait between attacks, from the archetype's range */
+	float GetRandomAttackDelay() const;
+
+	void RegisterWithSubsystems();
+	void UnregisterFromSubsystems(bool bNotifyRangeEnd);
+
+	/** Hands the mesh to the animation sharing manager, or takes it back to play montages on its own anim instance */
+	void SetAnimationShared(bool bShared);
+
+	bool bAnimationShared;
 };
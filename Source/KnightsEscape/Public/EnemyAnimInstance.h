@@ -4,8 +4,35 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "EnemyAnimInstance.generated.h"
 
+/** Pawn state copied on the game thread, turned into anim properties on an animation worker thread */
+USTRUCT()
+struct FEnemyAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FEnemyAnimInstanceProxy()
+		: FAnimInstanceProxy()
+		, Velocity(FVector::ZeroVector)
+	{}
+
+	FEnemyAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+		, Velocity(FVector::ZeroVector)
+	{}
+
+protected:
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+
+private:
+
+	FVector Velocity;
+};
+
 /**
  * 
  */
@@ -18,6 +45,7 @@ public:
 
 	virtual void NativeInitializeAnimation() override;
 
+	/** Kept for anim Blueprints that still call it; the properties are filled in by the proxy */
 	UFUNCTION(BlueprintCallable, Category = AnimationProperties)
 	void UpdateAnimationProperties();
 
@@ -29,4 +57,9 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Movement)
 	class AEnemy* Enemy;
+
+protected:
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return new FEnemyAnimInstanceProxy(this); }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override { delete InProxy; }
 };
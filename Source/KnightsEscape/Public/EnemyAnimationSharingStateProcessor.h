@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimationSharingTypes.h"
+#include "EnemyAnimationSharingStateProcessor.generated.h"
+
+/** Shared pose buckets for enemies; the AnimationSharingSetup asset maps each to a looping animation */
+UENUM(BlueprintType)
+enum class EEnemyAnimationSharingState : uint8
+{
+	EAS_Idle			UMETA(DisplayName = "Idle"),
+	EAS_Walk			UMETA(DisplayName = "Walk"),
+	EAS_Run				UMETA(DisplayName = "Run"),
+
+	EAS_MAX				UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * Sorts enemies into sharing buckets from their movement state and ground speed, so every enemy in
+ * the same bucket follows one leader pose. Attacking and dying enemies are not registered for sharing
+ * and evaluate their own montages instead.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyAnimationSharingStateProcessor : public UAnimationSharingStateProcessor
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyAnimationSharingStateProcessor();
+
+	/** Ground speed at which an enemy leaves the idle bucket */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
+	float WalkSpeed;
+
+	/** Ground speed at which an enemy moves from the walk to the run bucket */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
+	float RunSpeed;
+
+	virtual void ProcessActorState_Implementation(int32& OutState, AActor* InActor, uint8 CurrentState, uint8 OnDemandState, bool& bShouldProcess) override;
+
+	virtual UEnum* GetAnimationStateEnum_Implementation() override;
+};
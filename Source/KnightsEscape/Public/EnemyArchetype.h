@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "EnemyArchetype.generated.h"
+
+/**
+ * Tuning and asset references shared by every enemy of a type. Enemies point at one of these and only
+ * keep their changing state (health, movement state, targets) themselves, so a whole enemy type can be
+ * retuned in one place.
+ */
+UCLASS(BlueprintType)
+class KNIGHTSESCAPE_API UEnemyArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyArchetype();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	float MaxHealth;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	float Damage;
+
+	/** Distance at which the enemy notices a player */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	float AggroRadius;
+
+	/** Distance at which the enemy stops chasing and starts attacking */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	float CombatRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	class UParticleSystem* HitParticles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	class USoundCue* HitSound;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	USoundCue* BiteSound;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	class UAnimMontage* CombatMontage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	float AttackMinTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	float AttackMaxTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	TSubclassOf<UDamageType> DamageTypeClass;
+
+	/** Seconds a dead enemy lingers before it disappears, when it could not be left as a corpse */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	float DeathDelay;
+
+	/** Lets idle and moving enemies follow a shared leader pose; unset to always animate individually */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Animation")
+	class UAnimationSharingSetup* AnimationSharingSetup;
+};
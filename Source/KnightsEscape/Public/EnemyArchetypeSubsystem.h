@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyArchetypeSubsystem.generated.h"
+
+/**
+ * Shares one archetype per enemy class for Blueprints that still carry the tuning from before
+ * UEnemyArchetype. The archetype is built once from the class defaults, so every enemy of that class
+ * points at the same object and retuning the Blueprint retunes all of them.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyArchetypeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** Archetype migrated from EnemyClass's legacy tuning, built on first use */
+	class UEnemyArchetype* GetLegacyArchetype(UClass* EnemyClass);
+
+private:
+
+	UPROPERTY()
+	TMap<UClass*, UEnemyArchetype*> LegacyArchetypes;
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "EnemyCrowdSubsystem.generated.h"
+
+/** Planar state of one enemy for the avoidance pass */
+struct FCrowdAgent
+{
+	class AEnemy* Enemy;
+	FVector2D Position;
+	FVector2D Velocity;
+	float Radius;
+	float MaxSpeed;
+
+	/** Chasing enemies steer; everyone else only counts as an obstacle */
+	bool bSteering;
+};
+
+/**
+ * Velocity-obstacle style avoidance for chasing enemies, run as one batch per frame. Enemies are
+ * bucketed into a uniform grid, each chasing enemy looks at its neighbours in the surrounding cells,
+ * and steers away from any it would come within touching distance of over the time horizon. The
+ * result is picked up by UEnemyMovementComponent on the next movement update.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyCrowdSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyCrowdSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	void GatherAgents(float CellSize);
+
+	/** Avoidance velocity for Agents[Index]; only reads the agents and the grid, so it can run in parallel */
+	FVector2D ComputeAvoidance(int32 Index, float CellSize, float Padding, float TimeHorizon, int32 MaxNeighbours) const;
+
+	FIntPoint GetCell(const FVector2D& Position, float CellSize) const;
+
+	TArray<AEnemy*> Enemies;
+
+	/** Rebuilt every tick, kept to reuse their allocations */
+	TArray<FCrowdAgent> Agents;
+	TArray<FVector2D> Avoidance;
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Enemy.h"
+#include "EnemyDecisionSubsystem.generated.h"
+
+/** Command produced for an enemy by the decision pass */
+enum class EEnemyDecision : uint8
+{
+	None,
+	MoveToTarget,
+	Attack,
+	Idle
+};
+
+/** Copy of the state an enemy's decision depends on, safe to read off the game thread */
+struct FEnemyDecisionInput
+{
+	/** Only dereferenced on the game thread, when the decision is applied */
+	AEnemy* Enemy;
+	class AMainCharacter* AggroTarget;
+
+	EEnemyMovementState State;
+	float NextAttackTime;
+
+	bool bAlive;
+	bool bAttacking;
+	bool bAttackRequested;
+	bool bInCombatRange;
+	bool bCanSeeAggroTarget;
+	bool bTargetAlive;
+};
+
+/**
+ * Makes the per-frame chase / attack / give up decisions for every enemy. The game thread takes a
+ * snapshot of enemy and player state, worker threads evaluate it with a ParallelFor while the frame
+ * goes on, and the resulting commands are applied on the game thread at the start of the next tick.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyDecisionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyDecisionSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	/** Pure function of the snapshot, run on worker threads */
+	static EEnemyDecision Decide(const FEnemyDecisionInput& Input, float Now);
+
+	void WaitForDecisions();
+
+	void ApplyDecisions();
+
+	void GatherSnapshot();
+
+	TArray<AEnemy*> Enemies;
+
+	/** Enemies unregistered since the last snapshot, whose decisions must be skipped */
+	TSet<AEnemy*> RemovedEnemies;
+
+	/** Written by the game thread, then only read by the workers until the next tick */
+	TArray<FEnemyDecisionInput> Snapshot;
+	float SnapshotTime;
+
+	/** Written by the workers, one per snapshot entry */
+	TArray<EEnemyDecision> Decisions;
+
+	FGraphEventRef DecisionTask;
+};
\ No newline at end of file
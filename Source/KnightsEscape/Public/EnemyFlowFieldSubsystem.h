@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "EnemyFlowFieldSubsystem.generated.h"
+
+/** Navmesh sample for one world grid cell, cached until the navmesh is rebuilt */
+struct FFlowFieldNavCell
+{
+	float Z;
+	bool bWalkable;
+
+	/** One bit per cardinal neighbour (+X, -X, +Y, -Y): edge checked / edge traversable */
+	uint8 KnownEdges;
+	uint8 PassableEdges;
+};
+
+/** An enemy steering along the field toward its target */
+struct FFlowFieldFollower
+{
+	class AEnemy* Enemy;
+	TWeakObjectPtr<class AMainCharacter> Target;
+};
+
+/**
+ * Builds one Dijkstra distance field over a window of navmesh cells around the player and lets
+ * any number of chasing enemies read their steering direction from it in O(1), instead of each
+ * enemy running its own pathfinding query toward the player.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyFlowFieldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyFlowFieldSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** World size of one grid cell */
+	float CellSize;
+
+	/** Field window is (2 * WindowRadius + 1) cells across, centred on the player */
+	int32 WindowRadius;
+
+	/** Vertical size of a navmesh sampling layer, so stacked dungeon floors get separate cells */
+	float LayerHeight;
+
+	/** Largest height difference between neighbouring cells that still counts as connected */
+	float MaxStepHeight;
+
+	/** Whether MoveToTarget should steer along the field rather than request its own path */
+	static bool IsEnabled();
+
+	/** Starts steering Enemy toward Target; returns false if the enemy should path on its own instead */
+	bool AddFollower(AEnemy* Enemy, AMainCharacter* Target);
+	void RemoveFollower(AEnemy* Enemy);
+
+	/** Direction toward the field goal at Location; false if Location is outside or unreachable in the field */
+	bool SampleDirection(const FVector& Location, FVector& OutDirection) const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(class ANavigationData* NavData);
+
+	void BuildField(const FVector& GoalLocation);
+
+	/** Navmesh sample for a world cell on the given height layer, projecting it the first time it is seen */
+	const FFlowFieldNavCell& GetNavCell(const FIntPoint& Cell, int32 Layer, const ANavigationData& NavData);
+
+	/** Whether the cardinal edge from Cell in direction Edge can be walked, raycasting the navmesh the first time */
+	bool IsEdgePassable(const FIntPoint& Cell, int32 Edge, int32 Layer, const ANavigationData& NavData);
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	FORCEINLINE int32 GetWindowSize() const { return WindowRadius * 2 + 1; }
+
+	TArray<FFlowFieldFollower> Followers;
+
+	TMap<FIntVector, FFlowFieldNavCell> NavCache;
+
+	/** Current field: cost to goal and unit steering direction per window cell */
+	TArray<float> Distances;
+	TArray<FVector2D> Directions;
+
+	FIntPoint WindowOrigin;
+	FIntPoint GoalCell;
+	int32 GoalLayer;
+	bool bHasField;
+
+	/** Player the current field leads to */
+	TWeakObjectPtr<AMainCharacter> FieldTarget;
+
+	float TimeSinceBuild;
+
+	bool bBoundToNavigation;
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "EnemyHorde.generated.h"
+
+enum class EHordeMemberState : uint8
+{
+	Idle,
+	Chasing,
+	Promoted,
+	Dead
+};
+
+/** Horde member currently played by a real enemy actor */
+struct FPromotedHordeMember
+{
+	int32 Member;
+	TWeakObjectPtr<class AEnemy> Enemy;
+};
+
+/**
+ * A large crowd of low-fidelity enemies simulated as flat arrays and drawn as instances of a proxy
+ * mesh. Members close to the player are promoted into real enemies for melee, up to MaxPromoted at
+ * a time, and demoted back into the arrays once they are out of the fight. Moving members are checked
+ * against the navmesh a few at a time, which keeps them out of walls and off ledges and gives them
+ * their height.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API AEnemyHorde : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AEnemyHorde();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Horde")
+	class UBoxComponent* SpawningBox;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Horde")
+	class UInstancedStaticMeshComponent* ProxyMesh;
+
+	/** Enemy that promoted members become */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	TSubclassOf<AEnemy> EnemyClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 HordeSize;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float MoveSpeed;
+
+	/** Members within this distance of the player move toward it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float AggroRadius;
+
+	/** Members within this distance are promoted when a slot is free, and otherwise hold position */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float PromoteDistance;
+
+	/** Promoted enemies out of combat and further than this go back into the horde */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float DemoteDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 MaxPromoted;
+
+	/** Seconds a demoted member waits before it can be promoted again */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float PromoteCooldown;
+
+	/** Moving members checked against the navmesh each frame, in turn */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 NavChecksPerFrame;
+
+	UFUNCTION(BlueprintPure, Category = "Horde")
+	FORCEINLINE int32 GetNumAlive() const { return NumAlive; }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+
+	void SpawnMembers();
+
+	/** Steering and integration over the member arrays */
+	void Simulate(float DeltaTime, const FVector& PlayerLocation);
+
+	/** Moves the next NavChecksPerFrame moving members back onto the navmesh */
+	void ConstrainToNavigation();
+
+	/** Where Location is on the navmesh, or false when it is off it */
+	bool ProjectToNavigation(const FVector& Location, FVector& OutLocation) const;
+
+	void UpdatePromotions(const FVector& PlayerLocation);
+
+	void Promote(int32 Member);
+
+	/** Copies the promoted enemy back into its member and releases the actor */
+	void Demote(int32 PromotedIndex);
+
+	void UpdateInstances();
+
+	/** One entry per member in each array */
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	/** Last position found on the navmesh; PositionZ is its height */
+	TArray<float> NavPositionX;
+	TArray<float> NavPositionY;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> Health;
+	TArray<float> Cooldown;
+	TArray<EHordeMemberState> State;
+
+	TArray<FPromotedHordeMember> Promoted;
+
+	TArray<FTransform> InstanceTransforms;
+
+	int32 NumAlive;
+
+	/** Next member ConstrainToNavigation looks at */
+	int32 NextNavCheck;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "EnemyMovementComponent.generated.h"
+
+/**
+ * Character movement that bends the enemy's ground velocity by the avoidance velocity handed out
+ * by UEnemyCrowdSubsystem, so chasing enemies steer around each other instead of pushing capsules.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyMovementComponent(const FObjectInitializer& ObjectInitializer);
+
+	/** Avoidance velocity applied from the next movement update until it is replaced */
+	FORCEINLINE void SetCrowdVelocity(const FVector& Velocity) { CrowdVelocity = Velocity; }
+
+	FORCEINLINE const FVector& GetCrowdVelocity() const { return CrowdVelocity; }
+
+protected:
+
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
+
+private:
+
+	FVector CrowdVelocity;
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "EnemyPathSubsystem.generated.h"
+
+/** Last path found for an enemy and the goal it was built toward */
+struct FEnemyPathEntry
+{
+	FEnemyPathEntry()
+		: PathGoal(FVector::ZeroVector)
+		, bActive(false)
+		, bQueued(false)
+	{}
+
+	TWeakObjectPtr<class AMainCharacter> Target;
+	FNavPathSharedPtr Path;
+	FVector PathGoal;
+
+	/** Enemy is currently chasing and wants its path kept up to date */
+	bool bActive;
+
+	/** Waiting in the query queue */
+	bool bQueued;
+};
+
+/** Pending full pathfinding query */
+struct FEnemyPathQuery
+{
+	/** Squared distance to the target when queued; lower is served first */
+	float Priority;
+	class AEnemy* Enemy;
+};
+
+/**
+ * Owns enemy path requests: reuses each enemy's cached path while the target stays within a drift
+ * tolerance, splices the end of it when the target moves a little further, and queues full
+ * pathfinding queries behind a per-frame cap, closest enemies first.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyPathSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** Moves Enemy toward Target, from cache where possible, otherwise through the query queue */
+	void RequestPath(AEnemy* Enemy, AMainCharacter* Target);
+
+	void RemoveEnemy(AEnemy* Enemy);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	/** Follows the cached path, splicing it toward the new goal if needed; false if a fresh query is required */
+	bool TryReusePath(AEnemy* Enemy, FEnemyPathEntry& Entry);
+
+	void Enqueue(AEnemy* Enemy, FEnemyPathEntry& Entry);
+
+	void IssueQuery(AEnemy* Enemy, FEnemyPathEntry& Entry);
+
+	TMap<AEnemy*, FEnemyPathEntry> Entries;
+
+	TArray<FEnemyPathQuery> Queue;
+};
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "EnemyPerceptionSubsystem.generated.h"
+
+/** Cached line of sight from an enemy to the player in its aggro range */
+struct FEnemySightEntry
+{
+	FEnemySightEntry()
+		: Enemy(nullptr)
+		, bVisible(false)
+		, bPending(false)
+		, ResultTime(-BIG_NUMBER)
+		, RequestId(0)
+	{}
+
+	class AEnemy* Enemy;
+	TWeakObjectPtr<class AMainCharacter> Target;
+
+	bool bVisible;
+
+	/** An async trace is in flight */
+	bool bPending;
+
+	/** World time of the last trace result */
+	float ResultTime;
+
+	uint32 RequestId;
+};
+
+/**
+ * Answers "can this enemy see the player" from a cache filled by async line traces. Enemies in a
+ * player's aggro range are traced round-robin under a global per-frame budget, each again once its
+ * result is older than the time-to-live.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyPerceptionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyPerceptionSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Starts keeping Enemy's sight of Target up to date */
+	void WatchTarget(AEnemy* Enemy, AMainCharacter* Target);
+
+	void RemoveEnemy(AEnemy* Enemy);
+
+	/** Last known visibility of Target from Enemy; false until the first trace comes back */
+	bool CanSee(const AEnemy* Enemy, const AMainCharacter* Target) const;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	void IssueTrace(FEnemySightEntry& Entry);
+
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	TArray<FEnemySightEntry> Entries;
+
+	/** Where the next round-robin pass over Entries starts */
+	int32 NextEntry;
+
+	uint32 NextRequestId;
+
+	FTraceDelegate TraceDelegate;
+};
\ No newline at end of file
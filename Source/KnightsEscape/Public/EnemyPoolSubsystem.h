@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyPoolSubsystem.generated.h"
+
+/**
+ * Keeps dead enemies around, hidden and inactive, and hands them back out to spawners instead of
+ * constructing a new actor and AI controller for every spawn and destroying them on death.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyPoolSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Spawns Count inactive enemies of EnemyClass ahead of time, at Location */
+	void Prewarm(TSubclassOf<class AEnemy> EnemyClass, int32 Count, const FVector& Location);
+
+	/** Returns a reset enemy of EnemyClass placed at Location, reusing a pooled one when available */
+	AEnemy* AcquireEnemy(TSubclassOf<AEnemy> EnemyClass, const FVector& Location, const FRotator& Rotation);
+
+	/** Deactivates Enemy and keeps it for reuse; false if the pool for its class is full and it should be destroyed */
+	bool ReleaseEnemy(AEnemy* Enemy);
+
+	/** Forgets Enemy, for pooled enemies destroyed from outside (level unload) */
+	void RemoveEnemy(AEnemy* Enemy);
+
+	int32 GetNumPooledEnemies(TSubclassOf<AEnemy> EnemyClass) const;
+
+private:
+
+	/** Spawns an enemy with its AI controller, inactive and in the pool's care */
+	AEnemy* SpawnPooledEnemy(TSubclassOf<AEnemy> EnemyClass, const FVector& Location, const FRotator& Rotation);
+
+	/** Inactive enemies by class; the level keeps the actors alive */
+	TMap<UClass*, TArray<AEnemy*>> FreeEnemies;
+
+	int32 NumPooled;
+};
\ No newline at end of file
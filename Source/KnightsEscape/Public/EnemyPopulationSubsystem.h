@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Enemy.h"
+#include "EnemyPopulationSubsystem.generated.h"
+
+/** What is left of an enemy while it is far from the player: enough to bring it back as it was */
+USTRUCT()
+struct FVirtualEnemyRecord
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<AEnemy> EnemyClass;
+
+	UPROPERTY()
+	FTransform Transform;
+
+	UPROPERTY()
+	float Health;
+
+	UPROPERTY()
+	EEnemyMovementState EnemyMovementState;
+};
+
+/**
+ * Keeps only the enemies near the player as actors. Idle enemies that are far away and unseen are
+ * turned into records and their actors returned to UEnemyPoolSubsystem; records are brought back
+ * as live enemies, with their health, once the player comes within range again.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyPopulationSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyPopulationSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	FORCEINLINE int32 GetNumLiveEnemies() const { return Enemies.Num(); }
+	FORCEINLINE int32 GetNumVirtualEnemies() const { return Records.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	void Virtualise(AEnemy* Enemy);
+
+	AEnemy* Rehydrate(const FVirtualEnemyRecord& Record);
+
+	TArray<AEnemy*> Enemies;
+
+	UPROPERTY()
+	TArray<FVirtualEnemyRecord> Records;
+
+	float TimeSinceUpdate;
+};
\ No newline at end of file
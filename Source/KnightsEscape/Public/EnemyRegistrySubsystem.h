@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "EnemyRegistrySubsystem.generated.h"
+
+/** Per-enemy entry in the spatial hash */
+struct FRegisteredEnemy
+{
+	FIntPoint Cell;
+	float AggroRadius;
+	float CombatRadius;
+};
+
+/** Enemies that currently have a player character inside their aggro / combat range */
+struct FProximityTarget
+{
+	TWeakObjectPtr<class AMainCharacter> Main;
+	TArray<class AEnemy*> AggroEnemies;
+	TArray<AEnemy*> CombatEnemies;
+};
+
+/**
+ * Keeps every live enemy in a uniform spatial hash and runs one proximity pass per frame
+ * against the player characters, replacing the per-enemy AggroSphere / CombatSphere overlaps.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemyRegistrySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyRegistrySubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Edge length of a hash cell; queries scan enough rings to cover the largest aggro radius */
+	float CellSize;
+
+	void RegisterEnemy(AEnemy* Enemy);
+
+	/** Removes the enemy from the hash; with bNotify, fires range-end events for any player it was tracking */
+	void UnregisterEnemy(AEnemy* Enemy, bool bNotify);
+
+	/** Enemies whose aggro range currently contains Main, filtered by class when Filter is set */
+	void GetEnemiesInAggroRange(const AMainCharacter* Main, TArray<AEnemy*>& OutEnemies, UClass* Filter = nullptr) const;
+
+	bool IsInCombatRange(const AEnemy* Enemy, const AMainCharacter* Main) const;
+
+	FORCEINLINE int32 GetNumRegisteredEnemies() const { return Enemies.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void AddToCell(AEnemy* Enemy, const FIntPoint& Cell);
+	void RemoveFromCell(AEnemy* Enemy, const FIntPoint& Cell);
+
+	void UpdateTarget(FProximityTarget& Target);
+
+	TMap<AEnemy*, FRegisteredEnemy> Enemies;
+
+	TMap<FIntPoint, TArray<AEnemy*>> Cells;
+
+	TArray<FProximityTarget> Targets;
+
+	/** Largest aggro radius of any registered enemy, used to size the query ring */
+	float MaxAggroRadius;
+
+	/** Scratch buffers reused every frame */
+	TArray<AEnemy*> NewAggroEnemies;
+	TArray<AEnemy*> NewCombatEnemies;
+};
\ No newline at end of file
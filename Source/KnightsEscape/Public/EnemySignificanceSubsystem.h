@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Enemy.h"
+#include "EnemySignificanceSubsystem.generated.h"
+
+/** Update rates applied to an enemy while it sits in a significance tier */
+struct FSignificanceTierSettings
+{
+	float ActorTickInterval;
+	float AnimTickInterval;
+	float MovementTickInterval;
+	EVisibilityBasedAnimTickOption VisibilityBasedAnimTickOption;
+};
+
+/**
+ * Scores every enemy by distance to (and visibility from) the main character and assigns an
+ * update-rate tier, so distant enemies tick their actor, mesh and movement component less often.
+ * Enemies past the nav walking distance also move along the navmesh instead of sweeping for floors.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API UEnemySignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemySignificanceSubsystem();
+
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	FORCEINLINE int32 GetNumEnemiesInTier(EEnemySignificance Tier) const { return TierCounts[(int32)Tier]; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	/** Picks a tier for Distance, only leaving Current once Distance is past the hysteresis band */
+	EEnemySignificance ComputeTier(float Distance, EEnemySignificance Current) const;
+
+	void ApplyTier(AEnemy* Enemy, EEnemySignificance Tier);
+
+	/** Moves the enemy between full walking and navmesh walking, which skips floor sweeps */
+	void ApplyMovementLOD(AEnemy* Enemy, bool bNavWalking);
+
+	TArray<AEnemy*> Enemies;
+
+	FSignificanceTierSettings TierSettings[(int32)EEnemySignificance::ESI_MAX];
+
+	int32 TierCounts[(int32)EEnemySignificance::ESI_MAX];
+};
\ No newline at end of file
@@ -27,6 +27,23 @@ enum class EStaminaState : uint8
 	ESS_Default					UMETA(DisplayName = "DefaultMax")
 };
 
+/** Presses that can be buffered while an attack plays */
+enum class EBufferedInput : uint8
+{
+	AttackPrimary,
+	AttackSecondary,
+	Jump,
+	Interact
+};
+
+struct FBufferedInput
+{
+	EBufferedInput Input;
+
+	/** World time of the press */
+	float Time;
+};
+
 UCLASS()
 class KNIGHTSESCAPE_API AMainCharacter : public ACharacter
 {
@@ -84,6 +101,10 @@ public:
 
 	FORCEINLINE void SetCombatTarget(AEnemy* Target) { CombatTarget = Target; }
 
+	/** Chooses CombatTarget from the enemies whose aggro range the player is in */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
+	class UCombatTargetComponent* CombatTargetTracker;
+
 	FRotator GetLookAtRotationYaw(FVector Target);
 
 	/** Set movement state and running speed */
@@ -201,6 +222,20 @@ public:
 	void QuitKeyDown();
 	void QuitKeyUp();
 
+	/** Lock on to the next enemy on screen to the right / left of the current target */
+	void CycleTargetRight();
+	void CycleTargetLeft();
+
+	/** Releases the lock when either cycle key was held for ReleaseLockHoldTime */
+	void CycleTargetUp();
+
+	/** Seconds a cycle key has to be held to release the lock and go back to the closest enemy */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	float ReleaseLockHoldTime;
+
+	/** World time the last cycle key went down */
+	float CycleTargetPressTime;
+
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; };
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; };
 
@@ -222,6 +257,21 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void AttackEnd();
 
+	/** Seconds a press made during an attack is kept, waiting for a cancel window or the end of the attack */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	float InputBufferTime;
+
+	/**
+	 * Fraction of an attack section after which attacks and jumps may cut it short, for a CombatMontage
+	 * with no Cancel Window notifies of its own; 0 leaves such montages without cancel windows
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	float DefaultCancelWindowStart;
+
+	/** Lets the allowed inputs cut the current attack short, acting on any already buffered; opened by UAnimNotifyState_CancelWindow */
+	void OpenCancelWindow(bool bAllowAttack, bool bAllowJump, bool bAllowInteract);
+	void CloseCancelWindow();
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Anims")
 	class UAnimMontage* CombatMontage;
 
@@ -235,8 +285,6 @@ public:
 
 	virtual void Jump() override;
 
-	void UpdateCombatTarget();
-
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	TSubclassOf<AEnemy> EnemyFilter;
 
@@ -250,4 +298,37 @@ public:
 
 	UFUNCTION(BlueprintCallable)
 	void LoadGameNoSwitch();
+
+private:
+
+	void BufferInput(EBufferedInput Input);
+
+	/** Acts on the most recent unexpired buffered press that is allowed now, and clears the buffer if one was */
+	bool ConsumeBufferedInput();
+
+	/** Whether Input may act now, either outside an attack or through the open cancel window */
+	bool CanActOn(EBufferedInput Input) const;
+
+	/** Plays a primary or secondary swing, cutting short the current one when called through a cancel window */
+	void PerformAttack(bool bPrimary);
+
+	/** Stops the current swing so a jump or interaction can take over */
+	void CancelAttack();
+
+	/** Equips the weapon being overlapped */
+	void Interact();
+
+	/** Whether CombatMontage places its own cancel windows */
+	bool HasCancelWindowNotifies() const;
+
+	/** Opens the DefaultCancelWindowStart window for the swing in progress */
+	void OpenDefaultCancelWindow();
+
+	FTimerHandle DefaultCancelWindowTimer;
+
+	TArray<FBufferedInput, TInlineAllocator<4>> InputBuffer;
+
+	bool bCancelWindowAttack;
+	bool bCancelWindowJump;
+	bool bCancelWindowInteract;
 };
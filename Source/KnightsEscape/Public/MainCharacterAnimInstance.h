@@ -4,8 +4,38 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "MainCharacterAnimInstance.generated.h"
 
+/** Pawn state copied on the game thread, turned into anim properties on an animation worker thread */
+USTRUCT()
+struct FMainCharacterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FMainCharacterAnimInstanceProxy()
+		: FAnimInstanceProxy()
+		, Velocity(FVector::ZeroVector)
+		, bIsFalling(false)
+	{}
+
+	FMainCharacterAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+		, Velocity(FVector::ZeroVector)
+		, bIsFalling(false)
+	{}
+
+protected:
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+
+private:
+
+	FVector Velocity;
+	bool bIsFalling;
+};
+
 /**
  * 
  */
@@ -18,6 +48,7 @@ public:
 
 	virtual void NativeInitializeAnimation() override;
 
+	/** Kept for anim Blueprints that still call it; the properties are filled in by the proxy */
 	UFUNCTION(BlueprintCallable, Category = AnimationProperties)
 	void UpdateAnimationProperties();
 
@@ -33,4 +64,8 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Movement)
 	class AMainCharacter* MainCharacter;
 
+protected:
+
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return new FMainCharacterAnimInstanceProxy(this); }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override { delete InProxy; }
 };
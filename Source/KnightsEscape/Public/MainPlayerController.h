@@ -30,7 +30,8 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Widgets")
 	UUserWidget* EnemyHealthBar;
 
-	FVector EnemyLocation;
+	/** Where the combat target is on screen, kept up to date by UCombatTargetComponent */
+	FVector2D EnemyScreenPosition;
 
 	bool bEnemyHealthBarVisible;
 	void DisplayEnemyHealthBar();
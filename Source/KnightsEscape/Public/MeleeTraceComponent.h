@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MeleeTraceComponent.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FMeleeHitSignature, const FHitResult&);
+
+/**
+ * Detects melee hits by sweeping spheres along a box shape (a blade, a jaw) between where it was
+ * last frame and where it is now, while a swing is active. Long moves are split into sub-steps that
+ * blend the shape's transform, so fast swings at low frame rates still sweep the arc in between.
+ * Each actor is reported at most once per swing. The shape itself never needs collision enabled.
+ */
+UCLASS(ClassGroup = (Combat), meta = (BlueprintSpawnableComponent))
+class KNIGHTSESCAPE_API UMeleeTraceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UMeleeTraceComponent();
+
+	/** Points sampled along the longest axis of the shape */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	int32 NumSamples;
+
+	/** Furthest a sample point may move between two sweeps before the move is sub-stepped */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	float MaxStepDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Combat")
+	int32 MaxSubsteps;
+
+	/** Called once for each actor hit during a swing */
+	FMeleeHitSignature OnHit;
+
+	/** Box swept along the swing; its longest axis is the blade and the smaller extent the sweep radius */
+	void SetTraceShape(class UBoxComponent* Shape);
+
+	void BeginSwing();
+	void EndSwing();
+
+	FORCEINLINE bool IsSwinging() const { return bSwinging; }
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+
+	void Sweep(const FTransform& From, const FTransform& To);
+
+	UPROPERTY()
+	UBoxComponent* TraceShape;
+
+	/** Shape transform at the last sweep */
+	FTransform LastTransform;
+
+	/** Actors already hit this swing; only compared, never dereferenced */
+	TSet<AActor*> HitActors;
+
+	bool bSwinging;
+};
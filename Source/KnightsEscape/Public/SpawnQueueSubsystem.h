@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "SpawnQueueSubsystem.generated.h"
+
+/** Spawns requested together by a spawn volume, reported back once all of them are in the world */
+struct FSpawnBatch
+{
+	FSpawnBatch()
+		: BatchId(0)
+		, NextSpawn(0)
+		, PendingActor(nullptr)
+	{}
+
+	TWeakObjectPtr<class ASpawnVolume> Volume;
+	int32 BatchId;
+
+	TArray<UClass*> Classes;
+	TArray<FVector> Locations;
+
+	/** Index of the next spawn to start */
+	int32 NextSpawn;
+
+	/** Constructed but not yet finished spawning */
+	AActor* PendingActor;
+	FTransform PendingTransform;
+
+	TArray<AActor*> SpawnedActors;
+};
+
+/**
+ * Drains spawn batches queued by spawn volumes under a per-frame time budget. Actors are spawned
+ * deferred, so construction and FinishSpawning (construction scripts and BeginPlay) can land on
+ * different frames.
+ */
+UCLASS()
+class KNIGHTSESCAPE_API USpawnQueueSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	USpawnQueueSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/** Queues one spawn per entry of Classes at the matching Locations; returns the batch id passed to OnSpawnBatchComplete */
+	int32 QueueBatch(ASpawnVolume* Volume, const TArray<UClass*>& Classes, const TArray<FVector>& Locations);
+
+	/** Spawns queued but not yet finished */
+	FORCEINLINE int32 GetBacklog() const { return Backlog; }
+
+	/** Running average of the time taken by one spawn, in milliseconds */
+	FORCEINLINE float GetAverageSpawnCostMs() const { return AverageSpawnCostMs; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+private:
+
+	/** Does the next construction or finish step of Batch; true once the batch has nothing left to spawn */
+	bool StepBatch(FSpawnBatch& Batch);
+
+	/** Spawn setup shared with ASpawnVolume::SpawnActor, run once the actor has finished spawning */
+	void FinishSpawn(FSpawnBatch& Batch, AActor* Actor);
+
+	/** Held by pointer, since finishing a spawn runs BeginPlay, which may queue another batch and grow the array */
+	TArray<TUniquePtr<FSpawnBatch>> Batches;
+
+	int32 NextBatchId;
+	int32 Backlog;
+	float AverageSpawnCostMs;
+
+	/** Time spent on the spawn currently in progress, across its construction and finish steps */
+	double CurrentSpawnSeconds;
+};
\ No newline at end of file
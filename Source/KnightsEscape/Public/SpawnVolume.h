@@ -6,6 +6,8 @@
 #include "GameFramework/Actor.h"
 #include "SpawnVolume.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSpawnBatchCompleteSignature, int32, BatchId, const TArray<AActor*>&, SpawnedActors);
+
 UCLASS()
 class KNIGHTSESCAPE_API ASpawnVolume : public AActor
 {
@@ -33,6 +35,17 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
 	TArray<TSubclassOf<AActor>> SpawnArray;
 
+	/** Minimum distance between the cached spawn points handed out by GetSpawnPoint */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	float SpawnPointSpacing;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	int32 MaxSpawnPoints;
+
+	/** Inactive enemies of each spawnable enemy class created at level load, so spawns reuse them */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	int32 PoolPrewarmCount;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -41,6 +54,7 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/** A random cached spawn point on the navmesh; draws don't change any state, so it stays a pure node */
 	UFUNCTION(BlueprintPure, Category = "Spawning")
 	FVector GetSpawnPoint();
 
@@ -49,4 +63,27 @@ public:
 
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Spawning")
 	void SpawnActor(UClass* ToSpawn, const FVector& Location);
+
+	/** Queues Count spawns at spawn points, spread over frames by USpawnQueueSubsystem; picks from SpawnArray when ToSpawn is empty */
+	UFUNCTION(BlueprintCallable, Category = "Spawning")
+	int32 QueueSpawnBatch(TSubclassOf<AActor> ToSpawn, int32 Count);
+
+	/** Fired once every spawn of a queued batch is in the world */
+	UPROPERTY(BlueprintAssignable, Category = "Spawning")
+	FSpawnBatchCompleteSignature OnSpawnBatchComplete;
+
+private:
+
+	/** Fills SpawnPoints with a Poisson-disk set of navmesh points inside SpawningBox with room for a character */
+	void BuildSpawnPoints();
+
+	/** Lifts a navmesh spawn point to the capsule centre when SpawnClass is a character; other actors spawn on the ground */
+	FVector GetSpawnLocation(UClass* SpawnClass, const FVector& SpawnPoint) const;
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(class ANavigationData* NavData);
+
+	/** Spawn points on the navmesh */
+	TArray<FVector> SpawnPoints;
+	bool bSpawnPointsDirty;
 };
@@ -40,9 +40,13 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "SkeletalMesh")
 	class USkeletalMeshComponent* SkeletalMesh;
 
+	/** Shape of the blade, swept by MeleeTrace; it never has collision of its own */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Item | Combat")
 	class UBoxComponent* CombatCollision;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item | Combat")
+	class UMeleeTraceComponent* MeleeTrace;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Combat")
 	float Damage;
 
@@ -75,16 +79,26 @@ public:
 	FORCEINLINE void SetWeaponState(EWeaponState State) { WeaponState = State; }
 	FORCEINLINE EWeaponState GetWeaponState() { return WeaponState; }
 
-	UFUNCTION()
-	void CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult &SweepResult);
-	UFUNCTION()
-	void CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	/** Blade landed on something during the current swing */
+	void OnMeleeHit(const FHitResult& Hit);
 
+	/** Starts sweeping the blade for hits */
 	UFUNCTION(BlueprintCallable)
 	void ActivateCollision();
 
 	UFUNCTION(BlueprintCallable)
 	void DeactivateCollision();
 
+	/** Hit window opened by UAnimNotifyState_HitWindow, INDEX_NONE while none is open */
+	int32 ActiveHitWindow;
+
+	/** Multiplier on Damage for hits landed in the open hit window */
+	float HitDamageScale;
+
+	void OpenHitWindow(int32 WindowId, float DamageScale);
+
+	/** Closes the combat collision if WindowId is the window that opened it */
+	void CloseHitWindow(int32 WindowId);
+
 	FORCEINLINE void SetInstigator(AController* Instigator) { WeaponInstigator = Instigator; }
 };